@@ -9,6 +9,73 @@
 #include <stdint.h>
 #include <stdio.h>
 
+//1: Record only the 16 most significant bits of every sample. This halves the memory of the capture
+//buffers ('mic_buffer_raw' and 'mic_ring'), e.g. 20 KB instead of 40 KB at INPUT_SIZE 4096.
+//0: Record the full 32-bit samples.
+#define MIC_SAMPLES_16BIT 0
+
+//this one is a great trade-off between number of samples and expressivity(?) of the camptured sound. And it fits into RAM
+//With MIC_SAMPLES_16BIT, 4096 leaves more than half of the RAM free
+#define INPUT_SIZE 1024//4096//2048//8192//16384
+#define FS 16447
+//Number of new samples between two consecutive analysis frames. INPUT_SIZE / 4 gives 75% overlap,
+//INPUT_SIZE / 2 gives 50% overlap and INPUT_SIZE gives no overlap. INPUT_SIZE must be a multiple of it.
+#define HOP_SIZE (INPUT_SIZE / 4)//(INPUT_SIZE / 2)//INPUT_SIZE
+//0: Classify with the FFT.
+//1: Classify with the FFT and run the Goertzel detector (goertzel.h) on the same frames, to print its cycles
+//   and how often it agrees with the FFT.
+//2: Classify with the Goertzel detector only and skip the FFT.
+#define GOERTZEL_MODE 0
+//0: Classify with the FFT.
+//1: Classify with the FFT and run the streaming biquad filter bank (biquad_bank.h) on every hop, to print its
+//   cycles and how often it agrees with the FFT.
+//2: Classify with the biquad filter bank only and skip the FFT.
+#define BIQUAD_MODE 0
+#if GOERTZEL_MODE == 2 && BIQUAD_MODE == 2
+#error "Only one of GOERTZEL_MODE and BIQUAD_MODE can replace the FFT"
+#endif
+//1 if the frames are classified by their FFT. Without it, the FFT backend, its buffers and the spectrum state
+//are not compiled at all.
+#define FFT_CLASSIFICATION (GOERTZEL_MODE != 2 && BIQUAD_MODE != 2)
+
+//Number of classifications (see 'classification' in application.c), the length of the score vectors
+#define CLASSES 5
+
+#if MIC_SAMPLES_16BIT
+//The DMA only transfers the upper half of the DFSDM data register
+typedef int16_t mic_sample_t;
+//This is needed to normalize the microphone data
+#define MIC_SCALE_FACTOR (1.0f / INT16_MAX)
+//The DFSDM data has 24 bits, the sample holds the upper 16 of them
+#define MIC_SAMPLE_TO_24BIT(sample) ((int32_t)(sample) * 256)
+#define MIC_SAMPLE_TO_Q31(sample) ((int32_t)(sample) * 65536)
+#else
+//The DMA transfers the whole DFSDM data register, the 24 data bits are left-aligned
+typedef int32_t mic_sample_t;
+//This is needed to normalize the microphone data
+#define MIC_SCALE_FACTOR (1.0f / INT32_MAX)
+#define MIC_SAMPLE_TO_24BIT(sample) ((sample) >> 8)
+#define MIC_SAMPLE_TO_Q31(sample) (sample)
+#endif
+
+//Places a variable in SRAM2 (32 KB, see the .sram2 section in STM32L476RGTx_FLASH.ld).
+//It is zero filled at startup, initializers other than zero are ignored.
+#define SRAM2_DATA __attribute__((section(".sram2")))
+
+//1: Execute the hot DSP functions from SRAM2 (see the .ramfunc section in STM32L476RGTx_FLASH.ld),
+//without the flash wait states. 0: Execute them from flash, to compare the cycle counts printed by task().
+//Set by the USE_RAMFUNC option of CMakeLists.txt, which also selects whether the linker script takes the
+//CMSIS-DSP kernels into SRAM2, so both always move together.
+#ifndef USE_RAMFUNC
+#define USE_RAMFUNC 1
+#endif
+
+#if USE_RAMFUNC
+#define RAMFUNC __attribute__((section(".ramfunc")))
+#else
+#define RAMFUNC
+#endif
+
 void task(void);
 
 void dump_waveform(int32_t *buf, size_t len);
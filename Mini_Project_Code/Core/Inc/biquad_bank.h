@@ -0,0 +1,29 @@
+/**
+ * @file biquad_bank.h
+ * @brief Streaming band-pass filter bank with envelope followers, one band per class
+ * @author Carl, 2024
+ */
+#ifndef BIQUAD_BANK_H_
+#define BIQUAD_BANK_H_
+
+#include "application.h"
+
+//Bands of the classification: 20Hz - 800Hz, 800Hz - 1700Hz, 1700Hz - 2800Hz and 2800Hz - 7500Hz
+#define BIQUAD_BANDS 4
+//Time constant of the envelope followers in seconds
+#define BIQUAD_ENVELOPE_TIME 0.02f
+//Samples that are converted and filtered at once. The bank only needs buffers of this size instead
+//of a whole frame.
+#define BIQUAD_CHUNK 32
+
+//Prepare the filters (the coefficients are in flash).
+void biquad_bank_init(void);
+//Clear the filter states and the envelopes, before recording starts again after a gap.
+void biquad_bank_reset(void);
+//Filter the newest hop of HOP_SIZE samples as it arrives and update the envelopes. Has to be called for every hop.
+void biquad_bank_push_hop(const mic_sample_t *hop);
+//Centre frequency in Hz of the band with the strongest envelope at the end of the last hop. 'energy' returns
+//the sum of the envelopes, the mean square of the samples (normalized with MIC_SCALE_FACTOR) in the bands.
+int32_t biquad_bank_dominant_frequency(float *energy);
+
+#endif /* BIQUAD_BANK_H_ */
@@ -0,0 +1,38 @@
+/**
+ * @file class_table.h
+ * @brief Classification of the dominant frequency by a table of frequency ranges
+ * @author Carl, 2024
+ */
+#ifndef CLASS_TABLE_H_
+#define CLASS_TABLE_H_
+
+#include "application.h"
+
+typedef struct {
+    //Range of the dominant frequency in Hz, from 'low_hz' up to but without 'high_hz'
+    int32_t low_hz;
+    int32_t high_hz;
+    //Classification of the range (see 'classification' in application.c)
+    int16_t classification;
+    //Where ranges overlap, the one with the higher priority wins
+    int16_t priority;
+} class_range_t;
+
+//Most ranges a table can have
+#define CLASS_TABLE_MAX_RANGES 16
+
+//Default table in flash
+extern const class_range_t class_ranges_default[];
+extern const int class_ranges_default_count;
+
+//Resolve a table of up to CLASS_TABLE_MAX_RANGES ranges into sorted segments without overlaps (frequencies in no
+//range are 0). It can be called at any time with another table, e.g. one received at runtime, the table is
+//not kept. Calls Error_Handler() if the table is too long.
+void class_table_load(const class_range_t *ranges, int count);
+//Classification of a dominant frequency in Hz, by a binary search over the segments.
+int16_t class_table_lookup(int32_t frequency);
+//Frequencies from 'low_hz' up to but without 'high_hz' of the lowest run of neighbouring segments whose classes are
+//all in 'class_mask' (bit n for class n), in the table loaded last. Both are 0 if no segment has such a class.
+void class_table_span(uint32_t class_mask, int32_t *low_hz, int32_t *high_hz);
+
+#endif /* CLASS_TABLE_H_ */
@@ -0,0 +1,43 @@
+/**
+ * @file const_table.h
+ * @brief Macros to expand constant lookup tables of INPUT_SIZE or INPUT_SIZE / 2 entries in flash
+ * @author Carl, 2024
+ */
+#ifndef CONST_TABLE_H_
+#define CONST_TABLE_H_
+
+#include "application.h"
+
+//GCC folds __builtin_cos, __builtin_sqrt, __builtin_log10, ... of constants, so an initializer
+//{TABLE_INPUT_SIZE(F)} with such an F(n) is a constant expression and the table ends up in flash.
+
+//Expand F(n) for n, n + 1, ..., n + 4^k - 1
+#define TABLE_4(F, n)     F(n), F((n) + 1), F((n) + 2), F((n) + 3)
+#define TABLE_16(F, n)    TABLE_4(F, n), TABLE_4(F, (n) + 4), TABLE_4(F, (n) + 8), TABLE_4(F, (n) + 12)
+#define TABLE_64(F, n)    TABLE_16(F, n), TABLE_16(F, (n) + 16), TABLE_16(F, (n) + 32), TABLE_16(F, (n) + 48)
+#define TABLE_256(F, n)   TABLE_64(F, n), TABLE_64(F, (n) + 64), TABLE_64(F, (n) + 128), TABLE_64(F, (n) + 192)
+#define TABLE_1024(F, n)  TABLE_256(F, n), TABLE_256(F, (n) + 256), TABLE_256(F, (n) + 512), TABLE_256(F, (n) + 768)
+#define TABLE_4096(F, n)  TABLE_1024(F, n), TABLE_1024(F, (n) + 1024), TABLE_1024(F, (n) + 2048), TABLE_1024(F, (n) + 3072)
+#define TABLE_16384(F, n) TABLE_4096(F, n), TABLE_4096(F, (n) + 4096), TABLE_4096(F, (n) + 8192), TABLE_4096(F, (n) + 12288)
+
+//Whole table of INPUT_SIZE values of F (one per sample), and of INPUT_SIZE / 2 values (one per bin)
+#if INPUT_SIZE == 1024
+#define TABLE_INPUT_SIZE(F) TABLE_1024(F, 0)
+#define TABLE_BINS(F)       TABLE_256(F, 0), TABLE_256(F, 256)
+#elif INPUT_SIZE == 2048
+#define TABLE_INPUT_SIZE(F) TABLE_1024(F, 0), TABLE_1024(F, 1024)
+#define TABLE_BINS(F)       TABLE_1024(F, 0)
+#elif INPUT_SIZE == 4096
+#define TABLE_INPUT_SIZE(F) TABLE_4096(F, 0)
+#define TABLE_BINS(F)       TABLE_1024(F, 0), TABLE_1024(F, 1024)
+#elif INPUT_SIZE == 8192
+#define TABLE_INPUT_SIZE(F) TABLE_4096(F, 0), TABLE_4096(F, 4096)
+#define TABLE_BINS(F)       TABLE_4096(F, 0)
+#elif INPUT_SIZE == 16384
+#define TABLE_INPUT_SIZE(F) TABLE_16384(F, 0)
+#define TABLE_BINS(F)       TABLE_4096(F, 0), TABLE_4096(F, 4096)
+#else
+#error "No constant tables for this INPUT_SIZE"
+#endif
+
+#endif /* CONST_TABLE_H_ */
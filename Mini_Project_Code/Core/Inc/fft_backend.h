@@ -0,0 +1,123 @@
+/**
+ * @file fft_backend.h
+ * @brief Real FFT of a frame and its power spectrum, with exchangeable implementations
+ * @author Carl, 2024
+ */
+#ifndef FFT_BACKEND_H_
+#define FFT_BACKEND_H_
+
+#include "application.h"
+#include <stddef.h>
+
+//Implementations of the FFT. Only the selected one is compiled, the others are empty translation units.
+//Without FFT_CLASSIFICATION (see application.h) none is compiled, only the helpers at the end remain.
+//CMSIS_F32: arm_rfft_fast_f32 (fft_cmsis_f32.c)
+//CMSIS_Q31 and CMSIS_Q15: arm_rfft_q31 / arm_rfft_q15 with block scaling, up to an INPUT_SIZE of 8192 (fft_cmsis_fixed.c)
+//KISS: kiss_fftr in float, or in fixed point if FIXED_POINT is defined as 16 or 32 (fft_kiss.c)
+#define FFT_BACKEND_CMSIS_F32 1
+#define FFT_BACKEND_CMSIS_Q31 2
+#define FFT_BACKEND_CMSIS_Q15 3
+#define FFT_BACKEND_KISS 4
+
+//The backend is usually selected by the FFT_BACKEND option of CMakeLists.txt, which also sets FIXED_POINT
+//for all sources (kissfft itself has to be compiled with it).
+#ifndef FFT_BACKEND
+#define FFT_BACKEND FFT_BACKEND_CMSIS_F32
+#endif
+
+//1: Also compile the CMSIS_F32 backend as reference, its functions are called fft_reference_*.
+//task() then prints how often both classifications agree. Needs FFT_IN_SRAM2 0, the code of both fills SRAM2.
+#define FFT_COMPARE_CMSIS_F32 0
+
+//1: Place the FFT buffer of the CMSIS_F32 backend and a copy of its tables in SRAM2 next to the capture buffers.
+//Together with the RAM functions, this fits into the 32 KB of SRAM2 up to an INPUT_SIZE of 1024, set to 0 for larger sizes.
+#define FFT_IN_SRAM2 1
+
+#if FFT_IN_SRAM2
+#define FFT_DATA SRAM2_DATA
+#else
+#define FFT_DATA
+#endif
+
+#if FFT_BACKEND == FFT_BACKEND_CMSIS_F32
+#define FFT_BACKEND_NAME "CMSIS float"
+#elif FFT_BACKEND == FFT_BACKEND_CMSIS_Q31
+#define FFT_BACKEND_NAME "CMSIS q31"
+#elif FFT_BACKEND == FFT_BACKEND_CMSIS_Q15
+#define FFT_BACKEND_NAME "CMSIS q15"
+#elif FFT_BACKEND == FFT_BACKEND_KISS && !defined(FIXED_POINT)
+#define FFT_BACKEND_NAME "kissfft float"
+#elif FFT_BACKEND == FFT_BACKEND_KISS && FIXED_POINT == 32
+#define FFT_BACKEND_NAME "kissfft fixed point 32"
+#elif FFT_BACKEND == FFT_BACKEND_KISS && FIXED_POINT == 16
+#define FFT_BACKEND_NAME "kissfft fixed point 16"
+#else
+#error "Unknown FFT_BACKEND"
+#endif
+
+#if (FFT_BACKEND == FFT_BACKEND_CMSIS_Q31 || FFT_BACKEND == FFT_BACKEND_CMSIS_Q15) && INPUT_SIZE > 8192
+#error "The fixed-point real FFT of CMSIS supports up to 8192 samples"
+#endif
+#if FFT_COMPARE_CMSIS_F32 && (FFT_BACKEND == FFT_BACKEND_CMSIS_F32 || FFT_IN_SRAM2)
+#error "FFT_COMPARE_CMSIS_F32 needs another FFT_BACKEND and FFT_IN_SRAM2 0"
+#endif
+#if FFT_COMPARE_CMSIS_F32 && !FFT_CLASSIFICATION
+#error "FFT_COMPARE_CMSIS_F32 needs FFT_CLASSIFICATION"
+#endif
+
+//All backends produce the same spectrum: the frame is converted to the scale of MIC_SCALE_FACTOR, its DC offset
+//is removed and the analysis window is applied. The spectrum is the power (squared magnitude) of the bins, in float
+//and in the scale of an unnormalized DFT. Nothing downstream needs the magnitude itself, so there is no sqrt per bin.
+
+//Level of a frame in the time domain, normalized like the samples with MIC_SCALE_FACTOR.
+//It is computed while the frame is loaded, so silent frames can skip the FFT.
+typedef struct {
+    //RMS value without the DC offset
+    float rms;
+    //Largest deviation from the DC offset
+    float peak;
+    //Fraction of consecutive samples that lie on different sides of the DC offset
+    float zero_crossing_rate;
+    //DC offset in q31 (the scale of MIC_SAMPLE_TO_Q31)
+    int32_t mean;
+    //Number of bits the frame minus its DC offset can be shifted left without overflowing q31 (-1 at full scale).
+    //The fixed-point backends scale the whole frame with it, it then shares one exponent (block floating point).
+    int block_exponent;
+} frame_stats_t;
+
+//Set up the tables and buffers of the backend. Calls Error_Handler() on failure.
+void fft_init(void);
+//Convert the frame of INPUT_SIZE samples into the input buffer of the backend and apply the window.
+//The frame itself is not modified, it stays valid in the ring for the next overlapping frame.
+//Its level is returned in 'stats'.
+void fft_load(const mic_sample_t *frame, frame_stats_t *stats);
+//Real FFT of the loaded frame.
+void fft_forward(void);
+//Power of the INPUT_SIZE / 2 bins of the last FFT, without the bins below 20Hz.
+//The returned buffer belongs to the backend and is valid until the next fft_load().
+float* fft_power(void);
+//Bytes of static RAM used by the buffers and tables of the backend.
+size_t fft_memory(void);
+
+#if FFT_BACKEND == FFT_BACKEND_CMSIS_F32 && FFT_CLASSIFICATION
+//Print the cycles of fft_load() and fft_power() for one frame, next to the previous scalar conversion
+//loop and the magnitude (arm_cmplx_mag_f32) they replaced.
+void fft_benchmark(const mic_sample_t *frame);
+#endif
+
+#if FFT_COMPARE_CMSIS_F32
+void fft_reference_init(void);
+void fft_reference_load(const mic_sample_t *frame, frame_stats_t *stats);
+void fft_reference_forward(void);
+float* fft_reference_power(void);
+size_t fft_reference_memory(void);
+#endif
+
+//Helpers for the backends
+
+//Level of the frame in a single pass over the raw samples.
+void fft_frame_stats(const mic_sample_t *frame, frame_stats_t *stats);
+//Zero the bins below 20Hz of the spectrum.
+void fft_remove_lowest_bins(float *spectrum);
+
+#endif /* FFT_BACKEND_H_ */
@@ -0,0 +1,47 @@
+/**
+ * @file fingerprint.h
+ * @brief Binary spectral fingerprints, matched against a library of templates of known sounds in flash
+ * @author Carl, 2024
+ */
+#ifndef FINGERPRINT_H_
+#define FINGERPRINT_H_
+
+#include "application.h"
+
+//Bands of a frame, log spaced from FINGERPRINT_LOW_HZ to FS / 2. One bit per band, so a frame is one word.
+#define FINGERPRINT_BANDS 32
+#define FINGERPRINT_LOW_HZ 100
+//Frames of a template (FINGERPRINT_FRAMES * HOP_SIZE / FS seconds), oldest first
+#define FINGERPRINT_FRAMES 4
+//Most bits of the FINGERPRINT_FRAMES * FINGERPRINT_BANDS that may differ for a match
+#define FINGERPRINT_MAX_DISTANCE 12
+
+//A known sound. Define templates anywhere with FINGERPRINT_TEMPLATE, the linker collects them in the
+//.fingerprints section in flash (see STM32L476RGTx_FLASH.ld), so the library grows without a central list.
+typedef struct {
+    uint32_t bits[FINGERPRINT_FRAMES];
+    int16_t classification;  // that a matching frame gets, 0 for a nuisance sound that is not an intrusion
+    const char *name;
+} fingerprint_template_t;
+
+#define FINGERPRINT_TEMPLATE __attribute__((section(".fingerprints"), used, aligned(4))) const fingerprint_template_t
+
+//Result of fingerprint_match()
+typedef struct {
+    const fingerprint_template_t *match;  // NULL if no template is within FINGERPRINT_MAX_DISTANCE
+    int distance;
+    int compared_words;  // words compared before the early aborts, out of templates * FINGERPRINT_FRAMES
+} fingerprint_result_t;
+
+//Compute the bands of FINGERPRINT_BANDS bins.
+void fingerprint_init(void);
+//Forget the previous frames, after a frame that was not analysed.
+void fingerprint_reset(void);
+//Add the fingerprint of the power spectrum (INPUT_SIZE / 2 bins) of the next analysed frame, returns its bits.
+uint32_t fingerprint_push(const float *spectrum);
+//Find the template closest to the last FINGERPRINT_FRAMES frames. Needs as many frames since the last reset.
+void fingerprint_match(fingerprint_result_t *result);
+//Number of templates in the library
+int fingerprint_library_size(void);
+
+#endif /* FINGERPRINT_H_ */
@@ -0,0 +1,30 @@
+/**
+ * @file goertzel.h
+ * @brief Goertzel detector for the few frequencies the classification looks at, instead of a full FFT
+ * @author Carl, 2024
+ */
+#ifndef GOERTZEL_H_
+#define GOERTZEL_H_
+
+#include "application.h"
+
+//1: Run the Goertzel filters on every hop of HOP_SIZE samples as it arrives, and add up the power of the hops of a
+//frame. With overlapping frames, every sample is filtered once instead of INPUT_SIZE / HOP_SIZE times, at the
+//resolution of a hop (FS / HOP_SIZE).
+//0: Run them on the whole frame of INPUT_SIZE samples (per block), at the resolution of the FFT.
+#define GOERTZEL_STREAMING 1
+
+//Number of probe frequencies, see 'goertzel_probe_hop_bin' in goertzel.c
+#define GOERTZEL_PROBES 18
+
+//Compute the coefficients of the probes.
+void goertzel_init(void);
+#if GOERTZEL_STREAMING
+//Filter the newest hop of HOP_SIZE samples. Has to be called for every hop, also for the ones of silent frames.
+void goertzel_push_hop(const mic_sample_t *hop);
+#endif
+//Frequency in Hz of the strongest probe in the frame of INPUT_SIZE samples. With GOERTZEL_STREAMING, the samples
+//of 'frame' are not read: the power of its hops was already computed by goertzel_push_hop().
+int32_t goertzel_dominant_frequency(const mic_sample_t *frame);
+
+#endif /* GOERTZEL_H_ */
@@ -46,6 +46,11 @@ extern DFSDM_Filter_HandleTypeDef hdfsdm1_filter0;
 extern DFSDM_Channel_HandleTypeDef hdfsdm1_channel4;
 extern DMA_HandleTypeDef hdma_dfsdm1_flt0;
 extern volatile int mic_dma_finished_flag;
+extern volatile int mic_dma_half_finished_flag;
+extern volatile uint32_t mic_dma_overrun_count;
+extern volatile int mic_awd_triggered_flag;
+extern volatile int32_t mic_exd_max[2];
+extern volatile int32_t mic_exd_min[2];
 /* USER CODE END EC */
 
 /* Exported macro ------------------------------------------------------------*/
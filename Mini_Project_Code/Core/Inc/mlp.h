@@ -0,0 +1,29 @@
+/**
+ * @file mlp.h
+ * @brief int8 MLP over the log mel energies, with its weights in a blob in flash
+ * @author Carl, 2024
+ */
+#ifndef MLP_H_
+#define MLP_H_
+
+#include "application.h"
+#include "mel.h"
+
+//Inputs: the MEL_BANDS log mel energies, then the MLP_LEVEL_INPUTS of the level of the frame in the time domain
+//(natural log of the peak level, natural log of the crest factor and the zero crossing rate, see spectral_features.h)
+#define MLP_LEVEL_INPUTS 3
+#define MLP_INPUTS (MEL_BANDS + MLP_LEVEL_INPUTS)
+//Number of outputs of the last layer, one score per classification (see 'classification' in application.c)
+#define MLP_CLASSES CLASSES
+//Widest layer the activation arena holds
+#define MLP_MAX_WIDTH 64
+//Most layers the blob may have
+#define MLP_MAX_LAYERS 4
+
+//Check the blob (Core/Model/mlp_weights.bin, written by tools/mlp_blob.py) that is linked into flash.
+void mlp_init(void);
+//Run the MLP on its MLP_INPUTS inputs. Returns the classification with the highest score,
+//'scores' gets all MLP_CLASSES of them.
+int16_t mlp_classify(const float *inputs, float *scores);
+
+#endif /* MLP_H_ */
@@ -0,0 +1,32 @@
+/**
+ * @file multirate.h
+ * @brief Stream decimated by 4 with its own small FFT, for the low bands (voices and foot steps)
+ * @author Carl, 2024
+ */
+#ifndef MULTIRATE_H_
+#define MULTIRATE_H_
+
+#include "application.h"
+
+#define DECIMATION 4
+#define LOW_FS (FS / DECIMATION)
+//Samples of a frame of the decimated stream. INPUT_SIZE / 2 at LOW_FS spans twice the time of a full-rate
+//frame, so the bins are half as wide (8Hz instead of 16Hz at INPUT_SIZE 1024) with an FFT of half the size.
+#define LOW_INPUT_SIZE (INPUT_SIZE / 2)
+//Taps of the anti-aliasing lowpass in front of the decimation
+#define DECIMATION_TAPS 64
+
+//Prepare the decimation filter and the FFT of the decimated stream.
+void multirate_init(void);
+//Clear the decimated stream and the filter state, before recording starts again after a gap.
+void multirate_reset(void);
+//Decimate the newest hop of HOP_SIZE samples into the decimated stream. Has to be called for every hop.
+void multirate_push_hop(const mic_sample_t *hop);
+//1 once the decimated stream holds a whole frame of LOW_INPUT_SIZE samples since the last reset, after the start
+//transient of the decimation filter. Before, the frame would partly be zeros.
+int multirate_low_ready(void);
+//Power spectrum of the newest LOW_INPUT_SIZE decimated samples (LOW_INPUT_SIZE / 2 bins of LOW_FS / LOW_INPUT_SIZE).
+//It is only computed on demand, for the frames that need the low bands.
+float* multirate_low_power(void);
+
+#endif /* MULTIRATE_H_ */
@@ -0,0 +1,25 @@
+/**
+ * @file noise.h
+ * @brief Running noise floor of every bin and spectral subtraction
+ * @author Carl, 2024
+ */
+#ifndef NOISE_H_
+#define NOISE_H_
+
+#include "application.h"
+
+//The floor follows the power of a bin down quickly and up slowly, so it settles on the stationary noise
+//(fans, fridges, HVAC) while short sounds hardly move it. Per analysed frame, it moves by this share of the
+//difference: NOISE_RISE 0.01 takes about 100 frames (1.5 s of sound) to rise to a new noise level.
+#define NOISE_RISE 0.01f
+#define NOISE_FALL 0.5f
+//The floor is subtracted NOISE_OVERSUBTRACTION times, but NOISE_SPECTRAL_FLOOR of the power of a bin is
+//always kept, so the noise does not leave random isolated peaks behind
+#define NOISE_OVERSUBTRACTION 2.0f
+#define NOISE_SPECTRAL_FLOOR 0.05f
+
+//Update the floor (one value per bin, starts at zero) with a power spectrum of 'bins' bins and subtract it
+//from the spectrum in place, in one pass.
+void noise_subtract(float *spectrum, float *noise_floor, int bins);
+
+#endif /* NOISE_H_ */
@@ -0,0 +1,27 @@
+/**
+ * @file onset.h
+ * @brief Onset detector on the spectral flux, with a threshold that adapts to the recent frames
+ * @author Carl, 2024
+ */
+#ifndef ONSET_H_
+#define ONSET_H_
+
+#include "application.h"
+
+//Number of previous frames the threshold is averaged over (ONSET_HISTORY * HOP_SIZE / FS seconds)
+#define ONSET_HISTORY 8
+//An onset needs a flux ONSET_FACTOR times the mean flux of the previous frames, and at least ONSET_MIN_FLUX.
+//The flux is relative to the power of the frame: 1 for a sound after silence, around 0.1 - 0.5 for steady
+//sounds and noise (the bins of noise fluctuate from frame to frame).
+#define ONSET_FACTOR 2.0f
+#define ONSET_MIN_FLUX 0.6f
+//Frames in a row that have to be skipped as silent before the next sound is an onset against silence: a whole
+//frame. Over shorter dips, the flux compares with the last analysed frame.
+#define ONSET_MIN_GAP (INPUT_SIZE / HOP_SIZE)
+
+//Forget the previous frames, after a gap of silent frames.
+void onset_reset(void);
+//Feed the flux of the next analysed frame (spectral_features_t.flux), returns 1 if it is an onset.
+int onset_detect(float flux);
+
+#endif /* ONSET_H_ */
@@ -0,0 +1,48 @@
+/**
+ * @file spectral_features.h
+ * @brief Spectral descriptors of a frame, computed in one pass over the power spectrum
+ * @author Carl, 2024
+ */
+#ifndef SPECTRAL_FEATURES_H_
+#define SPECTRAL_FEATURES_H_
+
+#include "application.h"
+
+//Bands of the classification: 20Hz - 800Hz, 800Hz - 1700Hz, 1700Hz - 2800Hz and 2800Hz - FS / 2
+#define FEATURE_BANDS 4
+//Share of the power below the rolloff frequency
+#define ROLLOFF_PERCENT 0.85f
+
+typedef struct {
+    //Sum of the power of all bins
+    float total_power;
+    //Frequency of the strongest bin in Hz
+    int32_t dominant_frequency;
+    //Power weighted mean frequency in Hz
+    float centroid;
+    //Power weighted standard deviation of the frequency around the centroid in Hz
+    float bandwidth;
+    //Frequency in Hz below which ROLLOFF_PERCENT of the power lies
+    float rolloff;
+    //Geometric mean over arithmetic mean of the power (0: tonal, 1: white noise)
+    float flatness;
+    //Increase of the power over the previous frame, summed over the bins where it increased,
+    //relative to the total power of this frame (0: no new energy)
+    float flux;
+    //Level of the frame in the time domain. These are not computed from the spectrum, the caller sets them from
+    //the DFSDM extremes detector and from frame_stats_t (fft_backend.h).
+    //Peak-to-peak level from the DFSDM extremes detector, normalized like the samples
+    float peak_level;
+    //Largest deviation from the DC offset over the RMS value (1.4 for a sine, higher for impulsive sounds)
+    float crest_factor;
+    //Fraction of consecutive samples that lie on different sides of the DC offset
+    float zero_crossing_rate;
+    //Share of the total power in each of the FEATURE_BANDS bands
+    float band_energy[FEATURE_BANDS];
+} spectral_features_t;
+
+//Compute the spectral features of a power spectrum of INPUT_SIZE / 2 bins (the lowest 20Hz removed).
+//'previous' holds the power spectrum of the previous frame for the flux, it is replaced by this one.
+void spectral_features(const float *spectrum, float *previous, spectral_features_t *features);
+
+#endif /* SPECTRAL_FEATURES_H_ */
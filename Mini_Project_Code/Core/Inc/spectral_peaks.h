@@ -0,0 +1,27 @@
+/**
+ * @file spectral_peaks.h
+ * @brief Strongest peaks of a power spectrum with sub-bin frequency and power
+ * @author Carl, 2024
+ */
+#ifndef SPECTRAL_PEAKS_H_
+#define SPECTRAL_PEAKS_H_
+
+#include "application.h"
+
+//Number of peaks that are kept
+#define PEAKS_K 5
+
+typedef struct {
+    //Interpolated frequency in Hz
+    float frequency;
+    //Interpolated power of the peak
+    float power;
+    //Bin of the local maximum
+    int bin;
+} spectral_peak_t;
+
+//Find the PEAKS_K strongest local maxima of a power spectrum of 'bins' bins that are 'bin_hz' wide, in one pass.
+//Returns the number of peaks found (up to PEAKS_K), sorted by power, strongest first.
+int spectral_peaks(const float *spectrum, int bins, float bin_hz, spectral_peak_t *peaks);
+
+#endif /* SPECTRAL_PEAKS_H_ */
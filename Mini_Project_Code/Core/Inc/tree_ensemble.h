@@ -0,0 +1,60 @@
+/**
+ * @file tree_ensemble.h
+ * @brief Evaluator for tree ensembles generated into flash by tools/tree_codegen.py
+ * @author Carl, 2024
+ */
+#ifndef TREE_ENSEMBLE_H_
+#define TREE_ENSEMBLE_H_
+
+#include "application.h"
+#include "spectral_features.h"
+
+//Inputs of the trees, in the order of FEATURE_NAMES in tools/tree_codegen.py
+enum {
+    TREE_FEATURE_TOTAL_POWER,
+    TREE_FEATURE_DOMINANT_FREQUENCY,
+    TREE_FEATURE_CENTROID,
+    TREE_FEATURE_BANDWIDTH,
+    TREE_FEATURE_ROLLOFF,
+    TREE_FEATURE_FLATNESS,
+    TREE_FEATURE_FLUX,
+    TREE_FEATURE_PEAK_LEVEL,
+    TREE_FEATURE_CREST_FACTOR,
+    TREE_FEATURE_ZERO_CROSSING_RATE,
+    TREE_FEATURE_BAND_ENERGY,  // FEATURE_BANDS values
+    TREE_FEATURES = TREE_FEATURE_BAND_ENERGY + FEATURE_BANDS
+};
+//Number of scores, one per classification (see 'classification' in application.c)
+#define TREE_CLASSES CLASSES
+//'feature' of a leaf node
+#define TREE_LEAF 0xFF
+//What the summed scores of the leaves are ('tree_leaf_kind')
+//VOTES: votes or probabilities of every tree (random forest), not negative
+//LOGITS: unnormalized log-likelihoods (gradient boosted trees)
+#define TREE_LEAVES_VOTES 0
+#define TREE_LEAVES_LOGITS 1
+
+//8 bytes per node. The nodes of a tree are stored depth first, so the left child ('feature' <= 'threshold')
+//always follows its parent and only the index of the right child is stored. A leaf keeps the index of its
+//scores in 'right'.
+typedef struct {
+    float threshold;
+    uint16_t right;
+    uint8_t feature;
+    uint8_t reserved;
+} tree_node_t;
+
+//The generated model (Core/Src/tree_model.c)
+extern const tree_node_t tree_nodes[];
+extern const uint16_t tree_roots[];
+extern const float tree_leaf_scores[];
+extern const int tree_count;
+extern const int tree_leaf_kind;
+//Most nodes a frame can visit, over all trees
+extern const int tree_worst_case_nodes;
+
+//Sum the scores of the leaves the features end in over all trees. Returns the classification with the highest
+//score, 'scores' gets all TREE_CLASSES of them.
+int16_t tree_ensemble_classify(const spectral_features_t *features, float *scores);
+
+#endif /* TREE_ENSEMBLE_H_ */
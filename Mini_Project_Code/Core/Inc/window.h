@@ -0,0 +1,21 @@
+/**
+ * @file window.h
+ * @brief Analysis window applied to every frame before the FFT
+ * @author Carl, 2024
+ */
+#ifndef WINDOW_H_
+#define WINDOW_H_
+
+#include "application.h"
+
+//Hann window, or Hamming window if set to 0
+#define WINDOW_HANN 1
+
+//Window of INPUT_SIZE samples in flash. It is scaled to a mean power of 1, so the
+//energy of a windowed frame (and the RMS_THRESHOLD) stays the same as without window.
+extern const float analysis_window[INPUT_SIZE];
+//The same window for the fixed-point FFT in q31 and q15, scaled by 0.5 to fit into the format
+extern const int32_t analysis_window_q31[INPUT_SIZE];
+extern const int16_t analysis_window_q15[INPUT_SIZE];
+
+#endif /* WINDOW_H_ */
@@ -6,21 +6,99 @@
 
 #include "application.h"
 #include "arm_math.h"
-#include "kiss_fftr.h"
+#include "biquad_bank.h"
+#include "class_table.h"
+#include "fft_backend.h"
+#include "fingerprint.h"
+#include "goertzel.h"
+#include "mel.h"
+#include "mlp.h"
+#include "multirate.h"
+#include "noise.h"
+#include "onset.h"
+#include "spectral_features.h"
+#include "spectral_peaks.h"
+#include "tree_ensemble.h"
 #include "main.h"
 #include <inttypes.h>
 #include <stdio.h>
-
-//this one is a great trade-off between number of samples and expressivity(?) of the camptured sound. And it fits into RAM
-#define INPUT_SIZE 1024//4096//2048//8192//16384
-#define FS 16447
-//This is needed to normalize the microphone data
-#define MIC_SCALE_FACTOR (1.0f / INT32_MAX)
-
-//INT32 buffer for the microphone output
-int32_t mic_buffer_raw[INPUT_SIZE] = {0};
-//Float buffer for the FFT
-float mic_buffer[INPUT_SIZE] = {0};
+#include <string.h>
+
+//Frames with an RMS value (computed over the FFT magnitudes) below this threshold count as silence
+#define RMS_THRESHOLD 0.03f
+//The same threshold for the RMS of the samples (normalized with MIC_SCALE_FACTOR), which is measured while the
+//frame is converted. By Parseval's theorem, the RMS over the INPUT_SIZE/2 bins is sqrt(INPUT_SIZE) times the
+//RMS of the samples.
+#define FRAME_RMS_THRESHOLD (RMS_THRESHOLD / sqrtf(INPUT_SIZE))
+//Frames whose peak-to-peak level (from the DFSDM extremes detector, normalized like the samples) is below
+//this threshold are silent without even converting them. A signal cannot deviate from its mean by more than
+//its peak-to-peak level, so its RMS is below the FRAME_RMS_THRESHOLD.
+#define SILENCE_PEAK_THRESHOLD FRAME_RMS_THRESHOLD
+//The same threshold for the total power of the bins that is left after the noise floor is subtracted.
+//Frames that are louder than the RMS_THRESHOLD only because of stationary noise count as silence.
+#define REMAINING_POWER_THRESHOLD (RMS_THRESHOLD * RMS_THRESHOLD * (INPUT_SIZE / 2))
+//1: Between the analysed seconds, sleep until the analog watchdog of the DFSDM detects a sound.
+//0: Sleep for 2 seconds and analyse one second regardless of the sound level.
+#define WAKE_ON_SOUND 1
+//Number of samples the DFSDM filter needs to settle after starting before the analog watchdog is armed
+#define AWD_SETTLING_SAMPLES 16
+//1: Tell voices and foot steps apart on the stream decimated by 4 (see multirate.h), at twice the frequency
+//resolution. The full-rate spectrum still decides whether the dominant frequency is in the low bands at all.
+//Needs FFT_CLASSIFICATION.
+#define MULTIRATE_LOW_BANDS FFT_CLASSIFICATION
+//Classes refined on the decimated stream (bit n for class n): foot steps and voices. Their frequencies are taken
+//from the class table.
+#define MULTIRATE_LOW_CLASSES ((1u << 2) | (1u << 3))
+//0: Classify by the dominant frequency.
+//1: Also run the int8 MLP (mlp.h) on the log mel energies, to print its cycles and how often it agrees.
+//2: Classify with the MLP.
+#define MLP_MODE 0
+//1: Compute the log mel band energies (and the MFCCs) of every analysed frame, see mel.h. Needs FFT_CLASSIFICATION.
+//Only the MLP reads them, so they are not computed without it.
+#define MEL_FEATURES (MLP_MODE != 0)
+#if (MULTIRATE_LOW_BANDS || MEL_FEATURES) && !FFT_CLASSIFICATION
+#error "MULTIRATE_LOW_BANDS and MEL_FEATURES need the FFT"
+#endif
+#if MLP_MODE && !MEL_FEATURES
+#error "The MLP needs MEL_FEATURES"
+#endif
+//0: Classify by the dominant frequency.
+//1: Also run the tree ensemble generated by tools/tree_codegen.py (tree_ensemble.h) on the spectral features, to
+//print its cycles and how often it agrees.
+//2: Classify with the tree ensemble.
+#define TREE_MODE 0
+#if MLP_MODE == 2 && TREE_MODE == 2
+#error "Only one of MLP_MODE and TREE_MODE can classify"
+#endif
+//0: No fingerprints.
+//1: Match the fingerprint of every frame against the templates of known sounds (fingerprint.h), to print the
+//cycles and the matches.
+//2: A frame that matches a template gets its classification, so known nuisance sounds are not reported.
+#define FINGERPRINT_MODE 0
+//1: Print the fingerprint of every analysed frame, to record new templates (needs FINGERPRINT_MODE)
+#define FINGERPRINT_RECORD 0
+#if FINGERPRINT_MODE && !FFT_CLASSIFICATION
+#error "The fingerprints need the FFT"
+#endif
+_Static_assert(INPUT_SIZE % HOP_SIZE == 0, "INPUT_SIZE must be a multiple of HOP_SIZE");
+
+//Buffer for the microphone output. The DMA runs in circular mode over both halves
+//(ping-pong): while one half of HOP_SIZE samples is processed, the other one is recorded.
+//It lives in SRAM2, so the DMA transfers do not compete with the CPU accesses to the stack in SRAM1.
+SRAM2_DATA mic_sample_t mic_buffer_raw[2 * HOP_SIZE] = {0};
+//Half of 'mic_buffer_raw' that will be completed next by the DMA (0: first half, 1: second half)
+int mic_buffer_next_half = 0;
+//Ring buffer holding the last INPUT_SIZE samples. Every sample is stored twice (at i and
+//i + INPUT_SIZE), so the newest frame always starts at 'mic_ring_index' and is contiguous.
+//Frames are therefore only pointers into the ring and never copied together.
+SRAM2_DATA mic_sample_t mic_ring[2 * INPUT_SIZE] = {0};
+//Position in 'mic_ring' of the oldest sample, i.e. the start of the newest frame
+int mic_ring_index = 0;
+//Peak-to-peak level of every hop in 'mic_ring' from the DFSDM extremes detector (24-bit units)
+int32_t mic_ring_peak[INPUT_SIZE / HOP_SIZE] = {0};
+
+//Section boundaries from the linker script
+extern uint32_t _sdata, _ebss, _ssram2, _esram2, _sramfunc, _eramfunc;
 
 
 
@@ -30,139 +108,512 @@ float mic_buffer[INPUT_SIZE] = {0};
 //1: Intrusion detected: Glass break
 //2: Intrusion detected: foot steps
 //3: Intrusion detected: Voices
-//4: Intrusion detected: Other
+//4: Mosquito
 int16_t classification = 0;
+//Confidence of every classification for the current frame, they sum to 1
+float class_scores[CLASSES];
 
-//Counters for majority voting system
-int16_t glass_break_counter = 0;
-int16_t foot_steps_counter = 0;
-int16_t voices_counter = 0;
-int16_t mosquito_counter = 0;
-int16_t no_intrusion_detected_counter = 0;
+//Sums of the confidences of the frames for majority voting system. A frame the classifier is sure of counts
+//fully for its class, an unsure one only partly. Skipped silent and quiet frames count fully as no intrusion.
+float class_votes[CLASSES] = {0};
 
 //variables for the time per iteration of the task
 float total_time_for_recording_data = 0;
+float total_time_for_conversion = 0;
 float total_time_for_fft = 0;
-float total_time_for_rms = 0;
+float total_time_for_noise = 0;
 float total_time_for_classification = 0;
 float total_time_voting = 0;
 float total_time_active_task = 0;
 float total_time_for_sleep = 0;
+//Number of frames per second that were silent by their peak-to-peak level and skipped the conversion and the FFT
+int silent_frames = 0;
+//Number of frames per second that were silent by their RMS value and skipped the FFT
+int quiet_frames = 0;
+#if FFT_CLASSIFICATION
+//Noise floor of every bin, kept over all analysed frames and seconds
+float noise_floor[INPUT_SIZE / 2] = {0};
+//Spectral features of the last analysed frame, and the power spectrum of the frame before for the flux
+spectral_features_t features;
+float previous_spectrum[INPUT_SIZE / 2] = {0};
+//Strongest peaks of the last analysed frame, strongest first
+spectral_peak_t peaks[PEAKS_K];
+int peak_count = 0;
+//0 if 'previous_spectrum' was cleared (all zero), after a silent gap or at the start of a second
+int previous_spectrum_valid = 0;
+//Frames in a row that were not analysed (silent or quiet) before the current one, in this second
+int skipped_frames = 0;
+//Number of onsets per second, and how many of them raised the alarm right away
+int onsets = 0;
+int onset_alarms = 0;
+#endif
+#if MEL_FEATURES
+//Log mel band energies and MFCCs of the last analysed frame
+float mel_log_energy[MEL_BANDS];
+#if MFCC_COEFFS
+float mfcc[MFCC_COEFFS];
+#endif
+float total_time_for_mel = 0;
+#endif
+#if MLP_MODE
+//Scores of the classes from the MLP for the last analysed frame, and its cycles
+float mlp_scores[MLP_CLASSES];
+float total_time_for_mlp = 0;
+#endif
+#if MLP_MODE == 1
+//Number of frames the MLP classified like the dominant frequency
+int mlp_frames = 0;
+int mlp_agreements = 0;
+#endif
+#if TREE_MODE
+//Scores of the classes from the tree ensemble for the last analysed frame, and its cycles
+float tree_scores[TREE_CLASSES];
+float total_time_for_trees = 0;
+#endif
+#if TREE_MODE == 1
+//Number of frames the tree ensemble classified like the dominant frequency
+int tree_frames = 0;
+int tree_agreements = 0;
+#endif
+#if FINGERPRINT_MODE
+//Cycles of the fingerprints, frames that matched a template, and the words compared for the matching
+//(FINGERPRINT_FRAMES per template without the early abort)
+float total_time_for_fingerprint = 0;
+int fingerprint_frames = 0;
+int fingerprint_matches = 0;
+int fingerprint_compared_words = 0;
+#endif
+#if MULTIRATE_LOW_BANDS
+//Noise floor of the bins of the decimated stream
+float low_noise_floor[LOW_INPUT_SIZE / 2] = {0};
+//Cycles of the decimation of every hop, and of the FFT of the decimated stream
+float total_time_for_decimation = 0;
+float total_time_for_low_fft = 0;
+int low_fft_frames = 0;
+#endif
+#if BIQUAD_MODE
+//Cycles of the biquad filter bank
+float total_time_for_biquad = 0;
+#endif
+#if BIQUAD_MODE == 1
+//Number of frames the biquad filter bank classified like the FFT
+int biquad_frames = 0;
+int biquad_agreements = 0;
+#endif
+#if GOERTZEL_MODE
+//Cycles of the Goertzel detector (filtering the hops and finding the strongest probe)
+float total_time_for_goertzel = 0;
+#endif
+#if GOERTZEL_MODE == 1
+//Number of frames the Goertzel detector classified like the FFT
+int goertzel_frames = 0;
+int goertzel_agreements = 0;
+#endif
+#if FFT_COMPARE_CMSIS_F32
+//Cycles of the CMSIS float backend (conversion to RMS) on the same frames, and how often its classification agreed
+float total_time_for_float_reference = 0;
+int float_reference_frames = 0;
+int float_reference_agreements = 0;
+float reference_previous_spectrum[INPUT_SIZE / 2] = {0};
+float reference_noise_floor[INPUT_SIZE / 2] = {0};
+#endif
 
 
 //TIM handle for the timer used for the sleep function
 extern TIM_HandleTypeDef htim2;
 
-//Create a new arm_rfft_fast_instance_f32 and initialise it.
-arm_rfft_fast_instance_f32 S;
 
 
 
 // === Function prototypes ===
 void print_sampling_frequency();
-void Get_microphone_data(DFSDM_Filter_HandleTypeDef *hdfsdm1_filter0);
-float* DSP_FFT(arm_rfft_fast_instance_f32 *S);
-int16_t sound_classification(float *fft_results, float rms);
+void print_memory_usage(void);
+void Start_microphone_capture(DFSDM_Filter_HandleTypeDef *hdfsdm1_filter0);
+void Stop_microphone_capture(DFSDM_Filter_HandleTypeDef *hdfsdm1_filter0);
+void Push_microphone_block(void);
+const mic_sample_t* Get_microphone_data(void);
+float Get_frame_peak_level(void);
+RAMFUNC int16_t sound_classification(const spectral_features_t *features, float *scores);
+RAMFUNC int16_t classify_frequency(int32_t dominant_frequency);
+RAMFUNC void One_hot_scores(int16_t label, float *scores);
+#if MLP_MODE == 2 || TREE_MODE == 2
+RAMFUNC void Softmax_scores(const float *logits, float *scores);
+#endif
+#if FFT_CLASSIFICATION
+void Forget_previous_spectrum(void);
+void Skip_frame(void);
+#endif
+uint32_t Process_new_hop(void);
+int16_t biquad_classification(void);
 void Sleep_For_2_Seconds(void);
-float calculate_rms(float *fft_results, size_t len);
+void Listen_For_Sound(DFSDM_Filter_HandleTypeDef *hdfsdm1_filter0);
 
 
 
 // === Main task ===
 void task(void) {
 
-  // Initialize the CMSIS DSP FFT:
-  if (arm_rfft_fast_init_f32(&S, INPUT_SIZE) != ARM_MATH_SUCCESS) {
-        printf("FFT initialization failed.\r\n");
-        Error_Handler();
-    }
+  // Load the frequency ranges of the classes:
+  class_table_load(class_ranges_default, class_ranges_default_count);
+
+#if FFT_CLASSIFICATION
+  // Initialize the FFT backend:
+  fft_init();
+#endif
+#if FFT_COMPARE_CMSIS_F32
+  fft_reference_init();
+#endif
+#if GOERTZEL_MODE
+  goertzel_init();
+#endif
+#if MEL_FEATURES
+  mel_init();
+#endif
+#if MLP_MODE
+  mlp_init();
+#endif
+#if FINGERPRINT_MODE
+  fingerprint_init();
+  printf("Fingerprint library: %d templates\r\n", fingerprint_library_size());
+#endif
+#if TREE_MODE
+  printf("Tree ensemble: %d trees, worst case %d nodes per frame\r\n", tree_count, tree_worst_case_nodes);
+#endif
+#if MULTIRATE_LOW_BANDS
+  multirate_init();
+#endif
+#if BIQUAD_MODE
+  biquad_bank_init();
+#endif
+  print_memory_usage();
   
   // Enable the DWT cycle counter:
   CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
   DWT->CYCCNT = 0;
   DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 
+#if FFT_BACKEND == FFT_BACKEND_CMSIS_F32 && FFT_CLASSIFICATION
+  // Compare the conversion of a frame to float and the power spectrum with the previous code:
+  fft_benchmark(&mic_ring[mic_ring_index]);
+#endif
+
   // Start the main loop:
   while (1) {
     uint32_t start_active_task = DWT->CYCCNT;
     printf("\r\n\r\n");
-    // Read a fraction of the complete 1 second each iteration and do classification on it:
-    for (int i= 0; i < (FS / INPUT_SIZE); i++) {
+
+    // Record continuously for the whole second. The DMA keeps filling one half of the
+    // buffer while the previous half is being analysed, so no samples are lost between blocks.
+    uint32_t overruns_before = mic_dma_overrun_count;
+    // The last frame of the previous second is too old to compare the first frame with. The first frame is
+    // no onset either, the frames before it were not recorded.
+#if FFT_CLASSIFICATION
+    Forget_previous_spectrum();
+    skipped_frames = 0;
+#endif
+#if MULTIRATE_LOW_BANDS
+    multirate_reset();
+#endif
+#if BIQUAD_MODE
+    biquad_bank_reset();
+#endif
+    Start_microphone_capture(&hdfsdm1_filter0);
+
+    // Fill the ring with all but the last hop of the first frame, so the first frame only contains new samples.
+    uint32_t start_fill = DWT->CYCCNT;
+    for (int i = 0; i < INPUT_SIZE / HOP_SIZE - 1; i++) {
+      Push_microphone_block();
+      // The hop is part of the first frames. Its processing is not counted as recording.
+      start_fill += Process_new_hop();
+    }
+    total_time_for_recording_data += (float)(DWT->CYCCNT - start_fill);
+
+    // Analyse one overlapping frame per hop of the complete 1 second and do classification on it:
+    for (int i= 0; i < (FS / HOP_SIZE); i++) {
 
 
     //##### RECORDING DATA #####
 
     //measure start time
     uint32_t start = DWT->CYCCNT;
-    Get_microphone_data(&hdfsdm1_filter0);
+    const mic_sample_t *frame = Get_microphone_data();
     uint32_t stop = DWT->CYCCNT;
     // Calculate the number of DWT cycles the DFSDM took:
     uint32_t duration = stop - start;
     //add the time to the total time
     total_time_for_recording_data += (float)duration;
 
+    // Process the new hop (the end of the frame) right away, also in silent frames: the later frames contain it too.
+    Process_new_hop();
+
+
+
+    //##### SILENCE CHECK #####
+
+    // The extremes detector of the DFSDM measured the level of the frame for free.
+    // A silent frame is counted as "no intrusion" without computing the FFT.
+    float peak = Get_frame_peak_level();
+    if (peak < SILENCE_PEAK_THRESHOLD) {
+      class_votes[0] += 1.0f;
+      silent_frames++;
+#if FFT_CLASSIFICATION
+      Skip_frame();
+#endif
+      continue;
+    }
+
+
+
+    //##### CONVERSION #####
+
+    // Convert the newest frame in the ring and apply the window, into the input buffer of the FFT backend.
+    // The level of the frame is measured in the same pass over the samples that finds its DC offset.
+    frame_stats_t stats;
+    uint32_t start_conversion = DWT->CYCCNT;
+#if !FFT_CLASSIFICATION
+    // Without the FFT, only the level of the frame is needed
+    fft_frame_stats(frame, &stats);
+#else
+    fft_load(frame, &stats);
+#endif
+    uint32_t stop_conversion = DWT->CYCCNT;
+    // Calculate the number of DWT cycles the conversion took:
+    uint32_t duration_conversion = stop_conversion - start_conversion;
+    //add the time to the total time
+    total_time_for_conversion += (float)duration_conversion;
+
+    // A quiet frame is counted as "no intrusion" without computing the FFT.
+    if (stats.rms < FRAME_RMS_THRESHOLD) {
+      class_votes[0] += 1.0f;
+      quiet_frames++;
+#if FFT_CLASSIFICATION
+      Skip_frame();
+#endif
+      continue;
+    }
+
+
+
+#if GOERTZEL_MODE == 2
+    //##### GOERTZEL #####
 
+    // Classify the frame by the strongest probe of the Goertzel detector, without the FFT.
+    uint32_t start_goertzel = DWT->CYCCNT;
+    int32_t goertzel_frequency = goertzel_dominant_frequency(frame);
+    total_time_for_goertzel += (float)(DWT->CYCCNT - start_goertzel);
 
+    uint32_t start_classification = DWT->CYCCNT;
+    classification = classify_frequency(goertzel_frequency);
+    One_hot_scores(classification, class_scores);
+    total_time_for_classification += (float)(DWT->CYCCNT - start_classification);
+#elif BIQUAD_MODE == 2
+    //##### BIQUAD BANK #####
+
+    // The filter bank has already processed the hops of the frame, classify by its envelopes, without the FFT.
+    uint32_t start_classification = DWT->CYCCNT;
+    classification = biquad_classification();
+    One_hot_scores(classification, class_scores);
+    total_time_for_classification += (float)(DWT->CYCCNT - start_classification);
+#else
     //##### FFT #####
 
-    // Do DSP FFT of the microphone data from the 'mic_buffer' array.
+    // Do the FFT of the loaded frame and take the power of the bins.
     uint32_t start_fft = DWT->CYCCNT;
-    float *fft_results = DSP_FFT(&S);
+    fft_forward();
+    float *fft_results = fft_power();
     uint32_t stop_fft = DWT->CYCCNT;
     // Calculate the number of DWT cycles the FFT took:
     uint32_t duration_fft = stop_fft - start_fft;
     //add the time to the total time
     total_time_for_fft += (float)duration_fft;
 
-
-
-    //##### RMS #####
-
-    uint32_t start_rms = DWT->CYCCNT;
-    float rms = calculate_rms(fft_results, INPUT_SIZE / 2);
-    uint32_t stop_rms = DWT->CYCCNT;
-    // Calculate the number of DWT cycles the RMS took:
-    uint32_t duration_rms = stop_rms - start_rms;
-    //add the time to the total time
-    total_time_for_rms += (float)duration_rms;
-
+#if FINGERPRINT_MODE
+    //##### FINGERPRINT #####
+
+    // Before the noise subtraction, which would take out the steady nuisance sounds that are to be recognised
+    uint32_t start_fingerprint = DWT->CYCCNT;
+    uint32_t fingerprint_bits = fingerprint_push(fft_results);
+    fingerprint_result_t fingerprint;
+    fingerprint_match(&fingerprint);
+    total_time_for_fingerprint += (float)(DWT->CYCCNT - start_fingerprint);
+    fingerprint_frames++;
+    fingerprint_compared_words += fingerprint.compared_words;
+#if FINGERPRINT_RECORD
+    printf("Fingerprint 0x%08" PRIx32 "\r\n", fingerprint_bits);
+#else
+    (void)fingerprint_bits;
+#endif
+#endif
+
+    // Take the stationary noise out of the spectrum before any feature is computed.
+    uint32_t start_noise = DWT->CYCCNT;
+    noise_subtract(fft_results, noise_floor, INPUT_SIZE / 2);
+    total_time_for_noise += (float)(DWT->CYCCNT - start_noise);
+
+#if MEL_FEATURES
+    //##### MEL FEATURES #####
+
+    // Sum the power spectrum into the mel bands (before the classification changes it)
+    uint32_t start_mel = DWT->CYCCNT;
+    mel_log_energies(fft_results, mel_log_energy);
+#if MFCC_COEFFS
+    mel_mfcc(mel_log_energy, mfcc);
+#endif
+    total_time_for_mel += (float)(DWT->CYCCNT - start_mel);
+#endif
 
 
 
     //##### CLASSIFICATION #####
 
-    // Do sound classification based on the FFT results.
+    // Describe the spectrum in one pass and do sound classification based on it.
     uint32_t start_classification = DWT->CYCCNT;
-    classification = sound_classification(fft_results, rms);
+    // The flux can only be an onset against a recent analysed frame, or against the zeros after a real
+    // silent gap. After the reset at the start of a second, the frame only becomes the reference.
+    int onset_reference = previous_spectrum_valid || skipped_frames >= ONSET_MIN_GAP;
+    spectral_features(fft_results, previous_spectrum, &features);
+    previous_spectrum_valid = 1;
+    skipped_frames = 0;
+    // The level of the frame was measured in the time domain for free: by the DFSDM and while converting it.
+    // The RMS gate above makes sure the RMS is not zero.
+    features.peak_level = peak;
+    features.crest_factor = stats.peak / stats.rms;
+    features.zero_crossing_rate = stats.zero_crossing_rate;
+    // The interpolated frequency of the strongest peak is more precise than the bin of the maximum
+    peak_count = spectral_peaks(fft_results, INPUT_SIZE / 2, (float)FS / INPUT_SIZE, peaks);
+    if (peak_count > 0) {
+      features.dominant_frequency = (int32_t)(peaks[0].frequency + 0.5f);
+    }
+#if MULTIRATE_LOW_BANDS
+    // Only a frame whose dominant frequency is in the low bands needs the FFT of the decimated stream,
+    // its strongest peak replaces the coarser one of the full-rate spectrum. The first frames of a second
+    // keep the full-rate peak, until the decimated stream holds a whole frame.
+    int32_t low_band_low_hz, low_band_high_hz;
+    class_table_span(MULTIRATE_LOW_CLASSES, &low_band_low_hz, &low_band_high_hz);
+    if (low_band_high_hz > LOW_FS / 2) {
+      low_band_high_hz = LOW_FS / 2;
+    }
+    if (features.dominant_frequency >= low_band_low_hz && features.dominant_frequency < low_band_high_hz &&
+        multirate_low_ready()) {
+      uint32_t start_low_fft = DWT->CYCCNT;
+      float *low_results = multirate_low_power();
+      noise_subtract(low_results, low_noise_floor, LOW_INPUT_SIZE / 2);
+      spectral_peak_t low_peaks[PEAKS_K];
+      if (spectral_peaks(low_results, LOW_INPUT_SIZE / 2, (float)LOW_FS / LOW_INPUT_SIZE, low_peaks) > 0) {
+        // Only a peak inside the low bands replaces the full-rate one. Up to LOW_FS / 2, the decimated stream
+        // also holds what aliased in from above it, which must not turn the frame into another class.
+        int32_t low_frequency = (int32_t)(low_peaks[0].frequency + 0.5f);
+        if (low_frequency >= low_band_low_hz && low_frequency < low_band_high_hz) {
+          features.dominant_frequency = low_frequency;
+        }
+      }
+      uint32_t duration_low_fft = DWT->CYCCNT - start_low_fft;
+      total_time_for_low_fft += (float)duration_low_fft;
+      start_classification += duration_low_fft;
+      low_fft_frames++;
+    }
+#endif
+    classification = sound_classification(&features, class_scores);
     uint32_t stop_classification = DWT->CYCCNT;
     // Calculate the number of DWT cycles the classification took:
     uint32_t duration_classification = stop_classification - start_classification;
     //add the time to the total time
     total_time_for_classification += (float)duration_classification;
 
+#if MLP_MODE
+    //##### MLP #####
+
+    // Classify the log mel energies and the level of the frame with the MLP; frames without power over the
+    // noise floor stay silent.
+    uint32_t start_mlp = DWT->CYCCNT;
+    int16_t mlp_classification = 0;
+    if (features.total_power >= REMAINING_POWER_THRESHOLD) {
+      float mlp_inputs[MLP_INPUTS];
+      memcpy(mlp_inputs, mel_log_energy, sizeof(mel_log_energy));
+      mlp_inputs[MEL_BANDS] = fast_logf(features.peak_level);
+      mlp_inputs[MEL_BANDS + 1] = fast_logf(features.crest_factor);
+      mlp_inputs[MEL_BANDS + 2] = features.zero_crossing_rate;
+      mlp_classification = mlp_classify(mlp_inputs, mlp_scores);
+#if MLP_MODE == 2
+      Softmax_scores(mlp_scores, class_scores);
+#endif
+    }
+    total_time_for_mlp += (float)(DWT->CYCCNT - start_mlp);
+#if MLP_MODE == 1
+    mlp_frames++;
+    if (mlp_classification == classification) {
+      mlp_agreements++;
+    }
+#else
+    classification = mlp_classification;
+#endif
+#endif
+
+#if TREE_MODE
+    //##### TREE ENSEMBLE #####
+
+    // Classify the spectral features with the trees; frames without power over the noise floor stay silent.
+    uint32_t start_trees = DWT->CYCCNT;
+    int16_t tree_classification = 0;
+    if (features.total_power >= REMAINING_POWER_THRESHOLD) {
+      tree_classification = tree_ensemble_classify(&features, tree_scores);
+#if TREE_MODE == 2
+      if (tree_leaf_kind == TREE_LEAVES_LOGITS) {
+        Softmax_scores(tree_scores, class_scores);
+      } else {
+        // Votes or probabilities, one per tree
+        for (int c = 0; c < CLASSES; c++) {
+          class_scores[c] = tree_scores[c] / tree_count;
+        }
+      }
+#endif
+    }
+    total_time_for_trees += (float)(DWT->CYCCNT - start_trees);
+#if TREE_MODE == 1
+    tree_frames++;
+    if (tree_classification == classification) {
+      tree_agreements++;
+    }
+#else
+    classification = tree_classification;
+#endif
+#endif
+
+#if FINGERPRINT_MODE
+    // A known sound overrides the classifiers
+    if (fingerprint.match != NULL) {
+      fingerprint_matches++;
+#if FINGERPRINT_MODE == 2
+      classification = fingerprint.match->classification;
+      One_hot_scores(classification, class_scores);
+#endif
+    }
+#endif
+#endif
+
+
+
+#if FFT_CLASSIFICATION
+    //##### ONSET #####
+
+    // Glass break is impulsive and would only last for a few of the frames of the majority vote. A frame
+    // with a sudden rise of the spectral flux is classified on its own, and a glass break raises the alarm
+    // right away, one hop after the sound started instead of after the second.
+    if (onset_reference && onset_detect(features.flux)) {
+      onsets++;
+      if (classification == 1) {
+        onset_alarms++;
+        printf("Onset in frame %d: Intrusion detected: Glass break\r\n", i);
+      }
+    }
+#endif
 
 
     //##### VOTING #####
 
       uint32_t start_voting = DWT->CYCCNT;
-      switch (classification) {
-        case 0:
-          no_intrusion_detected_counter++;
-          break;
-        case 1:
-          glass_break_counter++;
-          break;
-        case 2:
-          foot_steps_counter++;
-          break;
-        case 3:
-          voices_counter++;
-          break;
-        case 4:
-          mosquito_counter++;
-          break;
-        default:
-          break;
+      for (int c = 0; c < CLASSES; c++) {
+        class_votes[c] += class_scores[c];
       }
       uint32_t stop_voting = DWT->CYCCNT;
 
@@ -170,61 +621,120 @@ void task(void) {
       uint32_t duration_voting = stop_voting - start_voting;
       //add the time to the total time
       total_time_voting += (float)duration_voting;
-    }
 
-    uint32_t start_voting = DWT->CYCCNT;
-    //weight no intrusion counter with less weight so quick changes are also detected
-    no_intrusion_detected_counter = no_intrusion_detected_counter / 5;
 
+#if GOERTZEL_MODE == 1
+      //##### GOERTZEL #####
 
-    //print all counters for debugging
-    //printf("No intrusion detected counter: %d\r\n", no_intrusion_detected_counter);
-    //printf("Glass break counter: %d\r\n", glass_break_counter);
-    //printf("Foot steps counter: %d\r\n", foot_steps_counter);
-    //printf("Voices counter: %d\r\n", voices_counter);
-    //printf("Mosquito counter: %d\r\n", mosquito_counter);
+      // Classify the same frame with the Goertzel detector (this overwrites 'classification').
+      int16_t fft_classification = classification;
+      uint32_t start_goertzel = DWT->CYCCNT;
+      int32_t goertzel_frequency = goertzel_dominant_frequency(frame);
+      total_time_for_goertzel += (float)(DWT->CYCCNT - start_goertzel);
+      goertzel_frames++;
+      if (classify_frequency(goertzel_frequency) == fft_classification) {
+        goertzel_agreements++;
+      }
+      classification = fft_classification;
+#endif
 
-    
-    
-    // Majority voting system (check which counter has the highest value)
-    if (no_intrusion_detected_counter > glass_break_counter && no_intrusion_detected_counter > foot_steps_counter && no_intrusion_detected_counter > voices_counter && no_intrusion_detected_counter > mosquito_counter) {
-      printf("No intrusion detected\r\n");
-    } 
-    else if (glass_break_counter > no_intrusion_detected_counter && glass_break_counter > foot_steps_counter && glass_break_counter > voices_counter && glass_break_counter > mosquito_counter) {
-      printf("Intrusion detected: Glass break\r\n");
-    } 
-    else if (foot_steps_counter > no_intrusion_detected_counter && foot_steps_counter > glass_break_counter && foot_steps_counter > voices_counter && foot_steps_counter > mosquito_counter) {
-      printf("Intrusion detected: Foot steps\r\n");
-    } 
-    else if (voices_counter > no_intrusion_detected_counter && voices_counter > glass_break_counter && voices_counter > foot_steps_counter && voices_counter > mosquito_counter) {
-      printf("Intrusion detected: Voices\r\n");
-    }
-    else if (mosquito_counter > no_intrusion_detected_counter && mosquito_counter > glass_break_counter && mosquito_counter > foot_steps_counter && mosquito_counter > voices_counter) {
-      printf("IT's A MOSQUITO!!! KILL IT BEFORE IT LAYS EGGS!!!\r\n");
-
-    } else {
-      //This case happens if there is a draw between the counters in this case we establish a hierarchy
-      //1. Glass break
-      //2. Foot steps
-      //3. Voices
-      //4. No Intrusion detected
-      //5. Mosquito
-      if (glass_break_counter >= foot_steps_counter && glass_break_counter >= voices_counter && glass_break_counter >= no_intrusion_detected_counter) {
-        printf("Intrusion detected: Glass break\r\n");
-      } 
-      else if (foot_steps_counter >= voices_counter && foot_steps_counter >= no_intrusion_detected_counter) {
-        printf("Intrusion detected: Foot steps\r\n");
-      } 
-      else if (voices_counter >= no_intrusion_detected_counter) {
-        printf("Intrusion detected: Voices\r\n");
-      } 
-      else if (mosquito_counter >= no_intrusion_detected_counter) {
-        printf("IT's A MOSQUITO!!! KILL IT BEFORE IT LAYS EGGS!!!\r\n");
+
+#if BIQUAD_MODE == 1
+      //##### BIQUAD BANK #####
+
+      // Classify the end of the same frame with the biquad filter bank (this overwrites 'classification').
+      int16_t fft_biquad_classification = classification;
+      uint32_t start_biquad = DWT->CYCCNT;
+      int16_t bank_classification = biquad_classification();
+      total_time_for_biquad += (float)(DWT->CYCCNT - start_biquad);
+      biquad_frames++;
+      if (bank_classification == fft_biquad_classification) {
+        biquad_agreements++;
       }
-      else {
-        printf("No intrusion detected\r\n");
+      classification = fft_biquad_classification;
+#endif
+
+
+#if FFT_COMPARE_CMSIS_F32
+      //##### FLOAT REFERENCE #####
+
+      // Classify the same frame with the CMSIS float backend (this overwrites 'classification').
+      int16_t backend_classification = classification;
+      uint32_t start_reference = DWT->CYCCNT;
+      frame_stats_t reference_stats;
+      fft_reference_load(frame, &reference_stats);
+      fft_reference_forward();
+      float *reference_results = fft_reference_power();
+      noise_subtract(reference_results, reference_noise_floor, INPUT_SIZE / 2);
+      uint32_t stop_reference = DWT->CYCCNT;
+      total_time_for_float_reference += (float)(stop_reference - start_reference);
+      float_reference_frames++;
+      spectral_features_t reference_features;
+      spectral_features(reference_results, reference_previous_spectrum, &reference_features);
+      reference_features.peak_level = peak;
+      reference_features.crest_factor = reference_stats.peak / reference_stats.rms;
+      reference_features.zero_crossing_rate = reference_stats.zero_crossing_rate;
+      spectral_peak_t reference_peaks[PEAKS_K];
+      if (spectral_peaks(reference_results, INPUT_SIZE / 2, (float)FS / INPUT_SIZE, reference_peaks) > 0) {
+        reference_features.dominant_frequency = (int32_t)(reference_peaks[0].frequency + 0.5f);
       }
-      
+      float reference_scores[CLASSES];
+      if (sound_classification(&reference_features, reference_scores) == backend_classification) {
+        float_reference_agreements++;
+      }
+#endif
+    }
+
+    // Stop recording so the DMA interrupts do not wake the microcontroller during sleep.
+    Stop_microphone_capture(&hdfsdm1_filter0);
+
+    uint32_t start_voting = DWT->CYCCNT;
+    //weight no intrusion with less weight so quick changes are also detected
+    //(rounded down like the integer counter before, so a draw still goes to the intrusion)
+    class_votes[0] = floorf(class_votes[0] / 5);
+
+
+    //print all votes for debugging
+    //printf("Votes: no intrusion %f, glass break %f, foot steps %f, voices %f, mosquito %f\r\n",
+    //       class_votes[0], class_votes[1], class_votes[2], class_votes[3], class_votes[4]);
+
+
+
+    // Majority voting system (check which class has the most votes)
+    //If there is a draw between the votes, we establish a hierarchy
+    //1. Glass break
+    //2. Foot steps
+    //3. Voices
+    //4. Mosquito
+    //5. No Intrusion detected
+    static const int16_t vote_hierarchy[CLASSES] = {1, 2, 3, 4, 0};
+    int16_t decision = vote_hierarchy[0];
+    float total_votes = 0;
+    for (int c = 0; c < CLASSES; c++) {
+      total_votes += class_votes[c];
+      if (class_votes[vote_hierarchy[c]] > class_votes[decision]) {
+        decision = vote_hierarchy[c];
+      }
+    }
+    //The confidence of the decision is its share of all votes of the second
+    float confidence = total_votes > 0 ? class_votes[decision] / total_votes : 0;
+
+    switch (decision) {
+      case 1:
+        printf("Intrusion detected: Glass break (confidence %.2f)\r\n", confidence);
+        break;
+      case 2:
+        printf("Intrusion detected: Foot steps (confidence %.2f)\r\n", confidence);
+        break;
+      case 3:
+        printf("Intrusion detected: Voices (confidence %.2f)\r\n", confidence);
+        break;
+      case 4:
+        printf("IT's A MOSQUITO!!! KILL IT BEFORE IT LAYS EGGS!!! (confidence %.2f)\r\n", confidence);
+        break;
+      default:
+        printf("No intrusion detected (confidence %.2f)\r\n", confidence);
+        break;
     }
 
     uint32_t stop_voting = DWT->CYCCNT;
@@ -234,12 +744,10 @@ void task(void) {
     total_time_voting += (float)duration_voting;
       
 
-    // Reset counters
-    glass_break_counter = 0;
-    foot_steps_counter = 0;
-    voices_counter = 0;
-    mosquito_counter = 0;
-    no_intrusion_detected_counter = 0;
+    // Reset votes
+    for (int c = 0; c < CLASSES; c++) {
+      class_votes[c] = 0;
+    }
 
 
     uint32_t stop_active_task = DWT->CYCCNT;
@@ -253,15 +761,82 @@ void task(void) {
     printf("Clock frequency: %.2f MHz\r\n", HAL_RCC_GetHCLKFreq() / 1e6);
     // Print the sampling frequency of the microphone
     print_sampling_frequency();
+    //Print the number of blocks that were overwritten before they could be processed
+    printf("Dropped blocks: %lu\r\n", (unsigned long)(mic_dma_overrun_count - overruns_before));
+    //Print the number of frames that were skipped because they were silent
+    printf("Silent frames: %d of %d\r\n", silent_frames, FS / HOP_SIZE);
+    //Print the number of frames that were converted, but skipped the FFT because they were quiet
+    printf("Quiet frames: %d of %d\r\n", quiet_frames, FS / HOP_SIZE);
+#if FFT_CLASSIFICATION
+    //Print the number of onsets and how many of them raised the alarm before the vote
+    printf("Onsets: %d, alarms on onset: %d\r\n", onsets, onset_alarms);
+#endif
     //Print the total time for each task
     printf("Total time for recording data: %f cycles\r\n", total_time_for_recording_data);
     printf("Or in seconds: %f\r\n", total_time_for_recording_data / 80e6);
 
+    printf("Total time for conversion: %f cycles\r\n", total_time_for_conversion);
+    printf("Or in seconds: %f\r\n", total_time_for_conversion / 80e6);
+
     printf("Total time for FFT: %f cycles\r\n", total_time_for_fft);
     printf("Or in seconds: %f\r\n", total_time_for_fft / 80e6);
 
-    printf("Total time for RMS: %f cycles\r\n", total_time_for_rms);
-    printf("Or in seconds: %f\r\n", total_time_for_rms / 80e6);
+    printf("Total time for noise floor and subtraction: %f cycles\r\n", total_time_for_noise);
+    printf("Or in seconds: %f\r\n", total_time_for_noise / 80e6);
+
+#if FFT_COMPARE_CMSIS_F32
+    //Print the CMSIS float backend (conversion, FFT and RMS) on the same frames for comparison
+    printf("Total time for float conversion, FFT and RMS: %f cycles\r\n", total_time_for_float_reference);
+    printf("Or in seconds: %f\r\n", total_time_for_float_reference / 80e6);
+    printf("Classification agrees with float: %d of %d frames\r\n", float_reference_agreements, float_reference_frames);
+#endif
+
+#if MULTIRATE_LOW_BANDS
+    printf("Total time for decimation: %f cycles\r\n", total_time_for_decimation);
+    printf("Or in seconds: %f\r\n", total_time_for_decimation / 80e6);
+    printf("Total time for low band FFT (%d points, %d frames): %f cycles\r\n", LOW_INPUT_SIZE, low_fft_frames, total_time_for_low_fft);
+    printf("Or in seconds: %f\r\n", total_time_for_low_fft / 80e6);
+#endif
+#if MLP_MODE
+    printf("Total time for MLP: %f cycles\r\n", total_time_for_mlp);
+    printf("Or in seconds: %f\r\n", total_time_for_mlp / 80e6);
+#endif
+#if MLP_MODE == 1
+    printf("Classification of MLP agrees with dominant frequency: %d of %d frames\r\n", mlp_agreements, mlp_frames);
+#endif
+#if FINGERPRINT_MODE
+    printf("Total time for fingerprints (%d templates): %f cycles\r\n", fingerprint_library_size(), total_time_for_fingerprint);
+    printf("Or in seconds: %f\r\n", total_time_for_fingerprint / 80e6);
+    printf("Fingerprint matched a template: %d of %d frames, %d words compared\r\n", fingerprint_matches,
+           fingerprint_frames, fingerprint_compared_words);
+#endif
+#if TREE_MODE
+    printf("Total time for tree ensemble: %f cycles\r\n", total_time_for_trees);
+    printf("Or in seconds: %f\r\n", total_time_for_trees / 80e6);
+#endif
+#if TREE_MODE == 1
+    printf("Classification of tree ensemble agrees with dominant frequency: %d of %d frames\r\n", tree_agreements, tree_frames);
+#endif
+#if MEL_FEATURES
+    printf("Total time for mel features (%d bands, %d MFCCs): %f cycles\r\n", MEL_BANDS, MFCC_COEFFS, total_time_for_mel);
+    printf("Or in seconds: %f\r\n", total_time_for_mel / 80e6);
+#endif
+#if BIQUAD_MODE
+    //Print the biquad filter bank, including the filtering of the hops of silent frames
+    printf("Total time for biquad filter bank (%d bands): %f cycles\r\n", BIQUAD_BANDS, total_time_for_biquad);
+    printf("Or in seconds: %f\r\n", total_time_for_biquad / 80e6);
+#endif
+#if BIQUAD_MODE == 1
+    printf("Classification of biquad filter bank agrees with FFT: %d of %d frames\r\n", biquad_agreements, biquad_frames);
+#endif
+#if GOERTZEL_MODE
+    //Print the Goertzel detector, including the filtering of the hops of silent frames
+    printf("Total time for Goertzel detector (%d probes): %f cycles\r\n", GOERTZEL_PROBES, total_time_for_goertzel);
+    printf("Or in seconds: %f\r\n", total_time_for_goertzel / 80e6);
+#endif
+#if GOERTZEL_MODE == 1
+    printf("Classification of Goertzel agrees with FFT: %d of %d frames\r\n", goertzel_agreements, goertzel_frames);
+#endif
 
     printf("Total time for classification: %f cycles\r\n", total_time_for_classification);
     printf("Or in seconds: %f\r\n", total_time_for_classification / 80e6);
@@ -276,15 +851,74 @@ void task(void) {
     
     //reset total time for recording data
     total_time_for_recording_data = 0;
+    total_time_for_conversion = 0;
     total_time_for_fft = 0;
-    total_time_for_rms = 0;
     total_time_for_classification = 0;
     total_time_voting = 0;
+    total_time_for_noise = 0;
+    silent_frames = 0;
+    quiet_frames = 0;
+#if FFT_CLASSIFICATION
+    onsets = 0;
+    onset_alarms = 0;
+#endif
+#if MLP_MODE
+    total_time_for_mlp = 0;
+#endif
+#if MLP_MODE == 1
+    mlp_frames = 0;
+    mlp_agreements = 0;
+#endif
+#if TREE_MODE
+    total_time_for_trees = 0;
+#endif
+#if FINGERPRINT_MODE
+    total_time_for_fingerprint = 0;
+    fingerprint_frames = 0;
+    fingerprint_matches = 0;
+    fingerprint_compared_words = 0;
+#endif
+#if TREE_MODE == 1
+    tree_frames = 0;
+    tree_agreements = 0;
+#endif
+#if MULTIRATE_LOW_BANDS
+    total_time_for_decimation = 0;
+    total_time_for_low_fft = 0;
+    low_fft_frames = 0;
+#endif
+#if MEL_FEATURES
+    total_time_for_mel = 0;
+#endif
+#if BIQUAD_MODE
+    total_time_for_biquad = 0;
+#endif
+#if BIQUAD_MODE == 1
+    biquad_frames = 0;
+    biquad_agreements = 0;
+#endif
+#if GOERTZEL_MODE
+    total_time_for_goertzel = 0;
+#endif
+#if GOERTZEL_MODE == 1
+    goertzel_frames = 0;
+    goertzel_agreements = 0;
+#endif
+#if FFT_COMPARE_CMSIS_F32
+    total_time_for_float_reference = 0;
+    float_reference_frames = 0;
+    float_reference_agreements = 0;
+#endif
 
 
     uint32_t start_sleep = DWT->CYCCNT;
+#if WAKE_ON_SOUND
+    // Sleep until the microphone picks up a sound (the cycle counter wraps after ~53 seconds of silence)
+    Listen_For_Sound(&hdfsdm1_filter0);
+#else
     // Sleep for 2 seconds (puts Microcontroller into sleep mode with a 2-second timer interrupt)
     Sleep_For_2_Seconds();
+#endif
     uint32_t stop_sleep = DWT->CYCCNT;
 
     // Calculate the number of DWT cycles the sleep took:
@@ -299,8 +933,54 @@ void task(void) {
 
 
 
-//Read data from the microphone and store it in the 'mic_buffer' array.
-void Get_microphone_data(DFSDM_Filter_HandleTypeDef *hdfsdm1_filter0) {
+//Start the continuous recording into the circular 'mic_buffer_raw' buffer.
+void Start_microphone_capture(DFSDM_Filter_HandleTypeDef *hdfsdm1_filter0) {
+  mic_buffer_next_half = 0;
+  mic_dma_half_finished_flag = 0;
+  mic_dma_finished_flag = 0;
+#if MIC_SAMPLES_16BIT
+  //CubeMX configures the DMA for 32-bit transfers, the MSB transfer reads the upper half-word of the data register
+  if (hdfsdm1_filter0->hdmaReg->Init.MemDataAlignment != DMA_MDATAALIGN_HALFWORD) {
+    hdfsdm1_filter0->hdmaReg->Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdfsdm1_filter0->hdmaReg->Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    if (HAL_DMA_Init(hdfsdm1_filter0->hdmaReg) != HAL_OK) {
+      printf("Failed to configure DMA!\r\n");
+      Error_Handler();
+    }
+  }
+  if (HAL_DFSDM_FilterRegularMsbStart_DMA(hdfsdm1_filter0, mic_buffer_raw, 2 * HOP_SIZE) != HAL_OK) {
+    printf("Failed to start DFSDM!\r\n");
+    Error_Handler();
+  }
+#else
+  if (HAL_DFSDM_FilterRegularStart_DMA(hdfsdm1_filter0, mic_buffer_raw, 2 * HOP_SIZE) != HAL_OK) {
+    printf("Failed to start DFSDM!\r\n");
+    Error_Handler();
+  }
+#endif
+  //The extremes detector tracks the level of every block, it is read in the DMA callbacks
+  if (HAL_DFSDM_FilterExdStart(hdfsdm1_filter0, DFSDM_CHANNEL_3) != HAL_OK) {
+    printf("Failed to start DFSDM extremes detector!\r\n");
+    Error_Handler();
+  }
+}
+
+
+//Stop the continuous recording.
+void Stop_microphone_capture(DFSDM_Filter_HandleTypeDef *hdfsdm1_filter0) {
+  if (HAL_DFSDM_FilterExdStop(hdfsdm1_filter0) != HAL_OK) {
+    printf("Failed to stop DFSDM extremes detector!\r\n");
+    Error_Handler();
+  }
+  if (HAL_DFSDM_FilterRegularStop_DMA(hdfsdm1_filter0) != HAL_OK) {
+    printf("Failed to stop DFSDM!\r\n");
+    Error_Handler();
+  }
+}
+
+
+//Wait for the next recorded half of 'mic_buffer_raw' and append it to the 'mic_ring' buffer.
+void Push_microphone_block(void) {
   // ==== Acquire microphone data: ===========================================
 
 
@@ -314,29 +994,126 @@ void Get_microphone_data(DFSDM_Filter_HandleTypeDef *hdfsdm1_filter0) {
   //Therefore to record for 1 second, we need to record 16.447kHz * 1s = 16'447 samples.
   //For ease of use I rounded this to the next power of 2, which is 2^14 = 16'384 samples.
 
-  //count clock cycles used to record the data
+  //The DMA is not stopped here: it already records the other half while this one is converted.
+  mic_sample_t *block;
+  if (mic_buffer_next_half == 0) {
+    while (!mic_dma_half_finished_flag) {
+    }
+    mic_dma_half_finished_flag = 0;
+    block = &mic_buffer_raw[0];
+  } else {
+    while (!mic_dma_finished_flag) {
+    }
+    mic_dma_finished_flag = 0;
+    block = &mic_buffer_raw[HOP_SIZE];
+  }
+  mic_ring_peak[mic_ring_index / HOP_SIZE] = mic_exd_max[mic_buffer_next_half] - mic_exd_min[mic_buffer_next_half];
+  mic_buffer_next_half ^= 1;
+
+  // Store the block twice so every frame in the ring stays contiguous.
+  // INPUT_SIZE is a multiple of HOP_SIZE, so a block never wraps around.
+  memcpy(&mic_ring[mic_ring_index], block, HOP_SIZE * sizeof(mic_sample_t));
+  memcpy(&mic_ring[mic_ring_index + INPUT_SIZE], block, HOP_SIZE * sizeof(mic_sample_t));
+  mic_ring_index = (mic_ring_index + HOP_SIZE) % INPUT_SIZE;
+}
+
+
+//Record the next hop and return the newest frame of INPUT_SIZE samples as a view into 'mic_ring'.
+const mic_sample_t* Get_microphone_data(void) {
+  Push_microphone_block();
+  return &mic_ring[mic_ring_index];
+}
+
+
+//Run the stages that work on every hop as it arrives (the Goertzel filters, the biquad bank and the decimation) on the
+//newest hop in 'mic_ring'. Returns the cycles they took.
+uint32_t Process_new_hop(void) {
+  const mic_sample_t *hop = &mic_ring[mic_ring_index + INPUT_SIZE - HOP_SIZE];
   uint32_t start = DWT->CYCCNT;
+#if GOERTZEL_MODE && GOERTZEL_STREAMING
+  goertzel_push_hop(hop);
+  uint32_t stop_goertzel = DWT->CYCCNT;
+  total_time_for_goertzel += (float)(stop_goertzel - start);
+#endif
+#if BIQUAD_MODE
+  uint32_t start_biquad = DWT->CYCCNT;
+  biquad_bank_push_hop(hop);
+  total_time_for_biquad += (float)(DWT->CYCCNT - start_biquad);
+#endif
+#if MULTIRATE_LOW_BANDS
+  uint32_t start_decimation = DWT->CYCCNT;
+  multirate_push_hop(hop);
+  total_time_for_decimation += (float)(DWT->CYCCNT - start_decimation);
+#endif
+  (void)hop;
+  return DWT->CYCCNT - start;
+}
 
-  mic_dma_finished_flag = 0;
-  if (HAL_DFSDM_FilterRegularStart_DMA(hdfsdm1_filter0, mic_buffer_raw, INPUT_SIZE) != HAL_OK) {
-    printf("Failed to start DFSDM!\r\n");
-    Error_Handler();
+
+//Classify by the band of the biquad filter bank with the strongest envelope at the end of the newest hop.
+//The envelopes are the mean square of the samples in the bands, so they are gated like the RMS of a frame.
+int16_t biquad_classification(void) {
+  float energy;
+  int32_t frequency = biquad_bank_dominant_frequency(&energy);
+  if (energy < FRAME_RMS_THRESHOLD * FRAME_RMS_THRESHOLD) {
+    classification = 0;
+    return classification;
   }
-  while (!mic_dma_finished_flag) {
+  return classify_frequency(frequency);
+}
+
+
+#if FFT_CLASSIFICATION
+//Count a frame that was not analysed. After ONSET_MIN_GAP of them in a row, clear the spectrum of the previous
+//frame and the onset history, so the next sound counts as an onset against silence.
+void Skip_frame(void) {
+  skipped_frames++;
+  if (skipped_frames == ONSET_MIN_GAP) {
+    Forget_previous_spectrum();
   }
-  if (HAL_DFSDM_FilterRegularStop_DMA(hdfsdm1_filter0) != HAL_OK) {
-    printf("Failed to start DFSDM!\r\n");
-    Error_Handler();
+}
+
+
+//Clear the spectrum of the previous frame and the onset history. Only the first call after an analysed frame
+//clears them.
+void Forget_previous_spectrum(void) {
+  if (previous_spectrum_valid) {
+    memset(previous_spectrum, 0, sizeof(previous_spectrum));
+    onset_reset();
+#if FINGERPRINT_MODE
+    fingerprint_reset();
+#endif
+    previous_spectrum_valid = 0;
   }
+}
+#endif
 
-  uint32_t stop = DWT->CYCCNT;
 
-  // Calculate the number of DWT cycles the DFSDM took:
-  uint32_t duration = stop - start;
-  // Scale and convert data from raw to float
-  for (int i = 0; i < INPUT_SIZE; i++) {
-    mic_buffer[i] = (float)mic_buffer_raw[i] * MIC_SCALE_FACTOR;
+//Peak-to-peak level of the newest frame, normalized like the samples with MIC_SCALE_FACTOR.
+//It is the largest level of the hops in the frame, so it costs no pass over the samples.
+float Get_frame_peak_level(void) {
+  int32_t peak = 0;
+  for (int i = 0; i < INPUT_SIZE / HOP_SIZE; i++) {
+    if (mic_ring_peak[i] > peak) {
+      peak = mic_ring_peak[i];
+    }
   }
+  return (float)peak / 8388608.0f;
+}
+
+
+//Print how the static data and the RAM functions are split between SRAM1 and SRAM2.
+void print_memory_usage(void) {
+    printf("Static data in SRAM1: %lu bytes\r\n", (unsigned long)((uint8_t *)&_ebss - (uint8_t *)&_sdata));
+    printf("Static data in SRAM2: %lu bytes\r\n", (unsigned long)((uint8_t *)&_esram2 - (uint8_t *)&_ssram2));
+    printf("Code in SRAM2: %lu bytes\r\n", (unsigned long)((uint8_t *)&_eramfunc - (uint8_t *)&_sramfunc));
+#if FFT_CLASSIFICATION
+    printf("FFT buffers (%s): %lu bytes\r\n", FFT_BACKEND_NAME, (unsigned long)fft_memory());
+    printf("Spectrum state (noise floor, previous spectrum): %lu bytes\r\n",
+           (unsigned long)(sizeof(noise_floor) + sizeof(previous_spectrum)));
+#else
+    printf("FFT buffers: none, the frames are classified without the FFT\r\n");
+#endif
 }
 
 
@@ -358,120 +1135,74 @@ void print_sampling_frequency() {
 }
 
 
-float* DSP_FFT(arm_rfft_fast_instance_f32 *S) {
-    // === Find dominant frequency using CMSIS DSP: ============================
-    
-    // The real-fft of INPUT_SIZE real samples will produce INPUT_SIZE/2 complex
-    // values, which require INPUT_SIZE floats to store:
-    //static float FFT_Buffer[INPUT_SIZE] = {0};
-
-    // Save time when RFFT started:
-    uint32_t cmsis_fft_start = DWT->CYCCNT;
-
-    //Compute the RFFT of 'IN_buffer' , and store the result in 'FFT_Buffer'
-    arm_rfft_fast_f32(S, mic_buffer, mic_buffer, 0); //$ SOL
 
-    // Save time when RFFT finished:
-    uint32_t cmsis_fft_stop = DWT->CYCCNT;
 
-    // Calculate the number of DWT cycles the KISS RFFT took:
-    uint32_t duration_cmsis = cmsis_fft_stop - cmsis_fft_start;
+RAMFUNC int16_t sound_classification(const spectral_features_t *features, float *scores) {
+    // Classify the sound into different categories.
+    // The classification is based on the dominant frequency of the sound, which the feature pass found
+    // (the strongest bin by power is also the strongest by magnitude).
 
-    //Convert complex samples to real samples by taking the magnitude:
-    
-    // Note that the FFT_Buffer only contains INPUT_SIZE/2 complex values, which
-    // requires INPUT_SIZE floats.
-    arm_cmplx_mag_f32(mic_buffer, mic_buffer, INPUT_SIZE / 2);
-
-    //remove the lowest 20Hz
-    for (int i = 0; i < 20 * INPUT_SIZE / FS; i++) {
-      mic_buffer[i] = 0;
+    // Not enough power is left over the noise floor
+    if (features->total_power < REMAINING_POWER_THRESHOLD) {
+      classification = 0;
+      One_hot_scores(classification, scores);
+      return classification;
     }
-
-    return mic_buffer;
-
+    classification = classify_frequency(features->dominant_frequency);
+
+    // The confidence that the frame is the sound and not the background grows with its power over the noise
+    // floor: 0 at REMAINING_POWER_THRESHOLD, 0.5 at twice and 0.9 at ten times of it. So a faint sound weighs
+    // less in the vote than a loud one. The rest goes to no intrusion.
+    float confidence = 1.0f - REMAINING_POWER_THRESHOLD / features->total_power;
+    One_hot_scores(0, scores);
+    scores[0] -= confidence;
+    scores[classification] += confidence;
+    return classification;
 }
 
 
-
-
-int16_t sound_classification(float *fft_results, float rms) {
-    // Process the FFT results and classify the sound into different categories.
-    // The classification is based on the dominant frequency of the sound.
-
-    // Find the maximum value in the FFT results:
-    float max_value = 0;
-    int max_index = 0;
-
-    //remove  (all frequencies under 20Hz)
-    for (int i = 0; i < 20 * INPUT_SIZE / FS; i++) {
-      fft_results[i] = 0;
-    }
-
-    for (int i = 0; i < INPUT_SIZE / 2; i++) {
-      if (fft_results[i] > max_value) {
-        max_value = fft_results[i];
-        max_index = i;
-      }
-    }
-
-    int32_t dominant_frequency = max_index * FS / INPUT_SIZE;
-
-    //Print to dominant frequency
-    //printf("Dominant frequency: %d Hz\r\n", dominant_frequency);
-    // Classify the sound based on the dominant frequency:
-
-    // If the RMS value is below a certain threshold, classify the sound as "No intrusion detected".
-    if (rms < 0.03) {
-      classification = 0;
-      return classification;
-    }
-    // Background: <20Hz
-    if (dominant_frequency < 20) {
-      classification = 0;
-      return classification;
+//Scores of a classifier that only gives a label: all confidence for it.
+RAMFUNC void One_hot_scores(int16_t label, float *scores) {
+    for (int c = 0; c < CLASSES; c++) {
+      scores[c] = 0;
     }
+    scores[label] = 1.0f;
+}
 
-    // Glass break: 1700Hz - 7kHz
-    if (dominant_frequency >= 1700 && dominant_frequency <= 20000) {
-      classification = 1;
-      return classification;
-    }
 
-    // Just a Mosquito: 1700Hz - 2800Hz
-    if (dominant_frequency >= 1700 && dominant_frequency <= 2800) {
-      classification = 4;
-      return classification;
+#if MLP_MODE == 2 || TREE_MODE == 2
+//Confidences from unnormalized log-likelihoods, the scores of the MLP or of gradient boosted trees.
+RAMFUNC void Softmax_scores(const float *logits, float *scores) {
+    float max = logits[0];
+    for (int c = 1; c < CLASSES; c++) {
+      if (logits[c] > max) {
+        max = logits[c];
+      }
     }
-
-    // Foot steps: 800Hz - 1700Hz
-    if (dominant_frequency >= 800 && dominant_frequency < 1700) {
-      classification = 2;
-      return classification;
+    float sum = 0;
+    for (int c = 0; c < CLASSES; c++) {
+      scores[c] = expf(logits[c] - max);
+      sum += scores[c];
     }
-
-    // Voices: 20Hz - 800Hz
-    if (dominant_frequency >= 20 && dominant_frequency < 800) {
-      classification = 3;
-      return classification;
+    for (int c = 0; c < CLASSES; c++) {
+      scores[c] /= sum;
     }
-
 }
+#endif
 
 
+//Classify a sound by its dominant frequency in Hz (from the FFT, the Goertzel detector or the biquad bank).
+RAMFUNC int16_t classify_frequency(int32_t dominant_frequency) {
+    //Print to dominant frequency
+    //printf("Dominant frequency: %d Hz\r\n", dominant_frequency);
 
-float calculate_rms(float *fft_results, size_t len) {
-    // Calculate the root mean square (RMS) value of the FFT results.
-    // The RMS value is used to determine if there is a sound present.
-    float sum = 0;
-    for (int i = 0; i < len; i++) {
-      sum += fft_results[i] * fft_results[i];
-    }
-    float rms = sqrt(sum / len);
-    return rms;
+    // The frequency ranges of the classes are in class_table.c, below 20Hz is background
+    classification = class_table_lookup(dominant_frequency);
+    return classification;
 }
 
 
+
 void Sleep_For_2_Seconds(void) {
  
     // Start TIM2 in interrupt mode
@@ -488,6 +1219,68 @@ void Sleep_For_2_Seconds(void) {
 }
 
 
+// Sleep until the microphone level leaves the quiet window around its DC offset.
+// Only the DFSDM filter keeps running (without DMA); its analog watchdog wakes the Microcontroller.
+void Listen_For_Sound(DFSDM_Filter_HandleTypeDef *hdfsdm1_filter0) {
+
+    // The watchdog compares single samples, so use the peak of a sine with the RMS of FRAME_RMS_THRESHOLD,
+    // in the 24-bit units of the filter output.
+    int32_t threshold = (int32_t)(FRAME_RMS_THRESHOLD * sqrtf(2.0f) * 8388608.0f);
+
+    // The microphone output is not centred on zero, so centre the window on the mean of the last frame.
+    const mic_sample_t *frame = &mic_ring[mic_ring_index];
+    int64_t sum = 0;
+    for (int i = 0; i < INPUT_SIZE; i++) {
+      sum += MIC_SAMPLE_TO_24BIT(frame[i]);
+    }
+    int32_t offset = (int32_t)(sum / INPUT_SIZE);
+
+    DFSDM_Filter_AwdParamTypeDef awd_param = {0};
+    awd_param.DataSource = DFSDM_FILTER_AWD_FILTER_DATA;
+    awd_param.Channel = DFSDM_CHANNEL_3;
+    awd_param.HighThreshold = offset + threshold < 8388607 ? offset + threshold : 8388607;
+    awd_param.LowThreshold = offset - threshold > -8388608 ? offset - threshold : -8388608;
+    awd_param.HighBreakSignal = DFSDM_NO_BREAK_SIGNAL;
+    awd_param.LowBreakSignal = DFSDM_NO_BREAK_SIGNAL;
+
+    // Run the filter without DMA; nobody reads the conversions except the watchdog.
+    if (HAL_DFSDM_FilterRegularStart(hdfsdm1_filter0) != HAL_OK) {
+      printf("Failed to start DFSDM!\r\n");
+      Error_Handler();
+    }
+
+    // Let the filter settle first, the first outputs after starting would trigger the watchdog.
+    for (int i = 0; i < AWD_SETTLING_SAMPLES; i++) {
+      if (HAL_DFSDM_FilterPollForRegConversion(hdfsdm1_filter0, 10) != HAL_OK) {
+        printf("DFSDM conversion timed out!\r\n");
+        Error_Handler();
+      }
+      uint32_t channel;
+      (void)HAL_DFSDM_FilterGetRegularValue(hdfsdm1_filter0, &channel);
+    }
+
+    mic_awd_triggered_flag = 0;
+    if (HAL_DFSDM_FilterAwdStart_IT(hdfsdm1_filter0, &awd_param) != HAL_OK) {
+      printf("Failed to start DFSDM analog watchdog!\r\n");
+      Error_Handler();
+    }
+
+    // Enter sleep mode; the Microcontroller will wake up on any interrupt, so go back to sleep
+    // until the interrupt was the watchdog.
+    HAL_SuspendTick();
+    while (!mic_awd_triggered_flag) {
+      HAL_PWR_EnterSLEEPMode(PWR_LOWPOWERREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+    }
+    HAL_ResumeTick();
+
+    // The callback already disarmed the watchdog
+    if (HAL_DFSDM_FilterRegularStop(hdfsdm1_filter0) != HAL_OK) {
+      printf("Failed to stop DFSDM!\r\n");
+      Error_Handler();
+    }
+}
+
+
 // Callback function called when TIM2 update interrupt occurs
 // This needs to be here for  the timer to function correctly
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
@@ -0,0 +1,96 @@
+/**
+ * @file biquad_bank.c
+ * @brief Streaming band-pass filter bank with envelope followers, one band per class
+ * @author Carl, 2024
+ */
+
+#include "biquad_bank.h"
+#include "arm_math.h"
+#include <math.h>
+#include <string.h>
+
+_Static_assert(HOP_SIZE % BIQUAD_CHUNK == 0, "HOP_SIZE must be a multiple of BIQUAD_CHUNK");
+
+//Every band is a Butterworth high-pass at its lower edge followed by a Butterworth low-pass at its upper
+//edge (2 biquads, 12dB per octave on both sides). The high-pass also removes the DC offset.
+//Coefficients from the Audio EQ Cookbook in the order of CMSIS {b0, b1, b2, -a1, -a2} / a0. The tables
+//are computed by the compiler like the analysis window.
+#define BIQUAD_PI 3.14159265358979323846
+#define BIQUAD_Q 0.70710678118654752440
+#define BIQUAD_COS(f) __builtin_cos(2.0 * BIQUAD_PI * (f) / FS)
+#define BIQUAD_ALPHA(f) (__builtin_sin(2.0 * BIQUAD_PI * (f) / FS) / (2.0 * BIQUAD_Q))
+#define BIQUAD_A0(f) (1.0 + BIQUAD_ALPHA(f))
+#define BIQUAD_FEEDBACK(f) (float)(2.0 * BIQUAD_COS(f) / BIQUAD_A0(f)), (float)(-(1.0 - BIQUAD_ALPHA(f)) / BIQUAD_A0(f))
+#define BIQUAD_LOWPASS(f) \
+    (float)((1.0 - BIQUAD_COS(f)) / 2.0 / BIQUAD_A0(f)), (float)((1.0 - BIQUAD_COS(f)) / BIQUAD_A0(f)), \
+    (float)((1.0 - BIQUAD_COS(f)) / 2.0 / BIQUAD_A0(f)), BIQUAD_FEEDBACK(f)
+#define BIQUAD_HIGHPASS(f) \
+    (float)((1.0 + BIQUAD_COS(f)) / 2.0 / BIQUAD_A0(f)), (float)(-(1.0 + BIQUAD_COS(f)) / BIQUAD_A0(f)), \
+    (float)((1.0 + BIQUAD_COS(f)) / 2.0 / BIQUAD_A0(f)), BIQUAD_FEEDBACK(f)
+
+static const float biquad_coefficients[BIQUAD_BANDS][2 * 5] = {
+    {BIQUAD_HIGHPASS(20), BIQUAD_LOWPASS(800)},
+    {BIQUAD_HIGHPASS(800), BIQUAD_LOWPASS(1700)},
+    {BIQUAD_HIGHPASS(1700), BIQUAD_LOWPASS(2800)},
+    {BIQUAD_HIGHPASS(2800), BIQUAD_LOWPASS(7500)},
+};
+//Geometric centre of every band
+static const int32_t biquad_band_frequency[BIQUAD_BANDS] = {126, 1166, 2182, 4583};
+
+arm_biquad_cascade_df2T_instance_f32 S_biquad[BIQUAD_BANDS];
+float biquad_state[BIQUAD_BANDS][2 * 2];
+//Mean square of the output of every band, smoothed over BIQUAD_ENVELOPE_TIME
+float biquad_envelope[BIQUAD_BANDS];
+//Weight of a new squared sample in the envelope
+float biquad_envelope_weight = 0;
+float biquad_input[BIQUAD_CHUNK];
+float biquad_output[BIQUAD_CHUNK];
+
+
+void biquad_bank_init(void) {
+    for (int band = 0; band < BIQUAD_BANDS; band++) {
+      arm_biquad_cascade_df2T_init_f32(&S_biquad[band], 2, biquad_coefficients[band], biquad_state[band]);
+    }
+    biquad_envelope_weight = 1.0f - expf(-1.0f / (BIQUAD_ENVELOPE_TIME * FS));
+    biquad_bank_reset();
+}
+
+
+void biquad_bank_reset(void) {
+    memset(biquad_state, 0, sizeof(biquad_state));
+    memset(biquad_envelope, 0, sizeof(biquad_envelope));
+}
+
+
+RAMFUNC void biquad_bank_push_hop(const mic_sample_t *hop) {
+    float weight = biquad_envelope_weight;
+    for (int chunk = 0; chunk < HOP_SIZE; chunk += BIQUAD_CHUNK) {
+#if MIC_SAMPLES_16BIT
+      arm_q15_to_float((q15_t *)&hop[chunk], biquad_input, BIQUAD_CHUNK);
+#else
+      arm_q31_to_float((q31_t *)&hop[chunk], biquad_input, BIQUAD_CHUNK);
+#endif
+      for (int band = 0; band < BIQUAD_BANDS; band++) {
+        arm_biquad_cascade_df2T_f32(&S_biquad[band], biquad_input, biquad_output, BIQUAD_CHUNK);
+        // One-pole smoothing of the squared output
+        float envelope = biquad_envelope[band];
+        for (int n = 0; n < BIQUAD_CHUNK; n++) {
+          envelope += weight * (biquad_output[n] * biquad_output[n] - envelope);
+        }
+        biquad_envelope[band] = envelope;
+      }
+    }
+}
+
+
+RAMFUNC int32_t biquad_bank_dominant_frequency(float *energy) {
+    float max_value;
+    uint32_t max_index;
+    arm_max_f32(biquad_envelope, BIQUAD_BANDS, &max_value, &max_index);
+    float sum = 0;
+    for (int band = 0; band < BIQUAD_BANDS; band++) {
+      sum += biquad_envelope[band];
+    }
+    *energy = sum;
+    return biquad_band_frequency[max_index];
+}
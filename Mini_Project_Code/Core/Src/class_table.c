@@ -0,0 +1,107 @@
+/**
+ * @file class_table.c
+ * @brief Classification of the dominant frequency by a table of frequency ranges
+ * @author Carl, 2024
+ */
+
+#include "class_table.h"
+#include "main.h"
+#include <stdio.h>
+
+//Glass break covers everything above 1700Hz, but the mosquito band inside of it has the higher priority.
+const class_range_t class_ranges_default[] = {
+    {20, 800, 3, 1},      // Voices
+    {800, 1700, 2, 1},    // Foot steps
+    {1700, 20000, 1, 1},  // Glass break
+    {1700, 2800, 4, 2},   // Mosquito
+};
+const int class_ranges_default_count = sizeof(class_ranges_default) / sizeof(class_ranges_default[0]);
+
+//The ranges resolved into segments without overlaps, sorted by frequency. Segment i reaches from
+//'class_edge_hz[i]' up to the next edge, frequencies below the first edge are 0. Neighbouring segments have
+//different classes. The lookup is a binary search in Hz, so it keeps the resolution of the interpolated peaks.
+int32_t class_edge_hz[2 * CLASS_TABLE_MAX_RANGES];
+int16_t class_of_segment[2 * CLASS_TABLE_MAX_RANGES];
+int class_segments = 0;
+
+
+//Class of the range with the highest priority that contains 'frequency', 0 if none does.
+static int16_t class_table_resolve(const class_range_t *ranges, int count, int32_t frequency) {
+    int16_t classification = 0;
+    int16_t priority = INT16_MIN;
+    for (int i = 0; i < count; i++) {
+      if (frequency >= ranges[i].low_hz && frequency < ranges[i].high_hz && ranges[i].priority > priority) {
+        classification = ranges[i].classification;
+        priority = ranges[i].priority;
+      }
+    }
+    return classification;
+}
+
+
+void class_table_load(const class_range_t *ranges, int count) {
+    if (count > CLASS_TABLE_MAX_RANGES) {
+      printf("Class table has more than %d ranges.\r\n", CLASS_TABLE_MAX_RANGES);
+      Error_Handler();
+    }
+
+    // The class can only change at the edges of the ranges. Sort them (insertion sort, there are few).
+    int32_t edges[2 * CLASS_TABLE_MAX_RANGES];
+    int edge_count = 0;
+    for (int i = 0; i < 2 * count; i++) {
+      int32_t edge = i % 2 ? ranges[i / 2].high_hz : ranges[i / 2].low_hz;
+      int j = edge_count;
+      while (j > 0 && edges[j - 1] > edge) {
+        edges[j] = edges[j - 1];
+        j--;
+      }
+      edges[j] = edge;
+      edge_count++;
+    }
+
+    int16_t previous = 0;
+    class_segments = 0;
+    for (int i = 0; i < edge_count; i++) {
+      int16_t classification = class_table_resolve(ranges, count, edges[i]);
+      if (classification != previous) {
+        class_edge_hz[class_segments] = edges[i];
+        class_of_segment[class_segments] = classification;
+        class_segments++;
+        previous = classification;
+      }
+    }
+}
+
+
+RAMFUNC int16_t class_table_lookup(int32_t frequency) {
+    // Number of edges at or below the frequency
+    int low = 0;
+    int high = class_segments;
+    while (low < high) {
+      int middle = (low + high) / 2;
+      if (class_edge_hz[middle] <= frequency) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+    return low > 0 ? class_of_segment[low - 1] : 0;
+}
+
+
+void class_table_span(uint32_t class_mask, int32_t *low_hz, int32_t *high_hz) {
+    *low_hz = 0;
+    *high_hz = 0;
+    int i = 0;
+    while (i < class_segments && !(class_mask & (1u << class_of_segment[i]))) {
+      i++;
+    }
+    if (i == class_segments) {
+      return;
+    }
+    *low_hz = class_edge_hz[i];
+    while (i < class_segments && (class_mask & (1u << class_of_segment[i]))) {
+      i++;
+    }
+    *high_hz = i < class_segments ? class_edge_hz[i] : INT32_MAX;
+}
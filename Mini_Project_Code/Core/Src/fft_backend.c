@@ -0,0 +1,65 @@
+/**
+ * @file fft_backend.c
+ * @brief Helpers shared by the FFT backends
+ * @author Carl, 2024
+ */
+
+#include "fft_backend.h"
+#include <math.h>
+
+//Plain C without CMSIS, so the kissfft backend also builds on a host.
+
+//The samples are accumulated relative to the DC offset of the previous frame. It drifts slowly, so the sums stay
+//small and the variance does not lose precision to the offset, without a second pass to find the mean first.
+//The zero crossings are counted around it as well, so they are only exact once the pivot has settled (from the
+//second frame on).
+int32_t fft_stats_pivot = 0;
+
+RAMFUNC void fft_frame_stats(const mic_sample_t *frame, frame_stats_t *stats) {
+    // In 24-bit units, the squares of INPUT_SIZE samples fit into 64 bits
+    int32_t pivot = fft_stats_pivot;
+    int64_t sum = 0;
+    int64_t sum_of_squares = 0;
+    int32_t min = INT32_MAX;
+    int32_t max = INT32_MIN;
+    int32_t previous = 0;
+    int crossings = 0;
+    for (int i = 0; i < INPUT_SIZE; i++) {
+      int32_t sample = MIC_SAMPLE_TO_24BIT(frame[i]) - pivot;
+      sum += sample;
+      sum_of_squares += (int64_t)sample * sample;
+      if (sample < min) {
+        min = sample;
+      }
+      if (sample > max) {
+        max = sample;
+      }
+      // The sign bit of the XOR of two consecutive samples is set if they lie on different sides
+      crossings += (uint32_t)(sample ^ previous) >> 31;
+      previous = sample;
+    }
+    // The first sample is compared with zero, which counts a crossing for half of the frames
+    crossings -= (uint32_t)(MIC_SAMPLE_TO_24BIT(frame[0]) - pivot) >> 31;
+
+    int32_t offset = (int32_t)(sum / INPUT_SIZE);
+    float mean = (float)sum / INPUT_SIZE;
+    float variance = (float)sum_of_squares / INPUT_SIZE - mean * mean;
+    int32_t deviation = max - offset > offset - min ? max - offset : offset - min;
+
+    fft_stats_pivot = pivot + offset;
+    stats->rms = variance > 0 ? sqrtf(variance) / 8388608.0f : 0;
+    stats->peak = (float)deviation / 8388608.0f;
+    stats->zero_crossing_rate = (float)crossings / (INPUT_SIZE - 1);
+    stats->mean = (int32_t)((uint32_t)fft_stats_pivot << 8);
+    // Shift so the largest deviation just fits below the sign bit (GCC emits a CLZ instruction).
+    // A frame that uses the full range of the 24 bits needs a shift to the right (-1).
+    stats->block_exponent = deviation > 0 ? __builtin_clz((uint32_t)deviation << 8) - 1 : 0;
+}
+
+
+RAMFUNC void fft_remove_lowest_bins(float *spectrum) {
+    //remove the lowest 20Hz
+    for (int i = 0; i < 20 * INPUT_SIZE / FS; i++) {
+      spectrum[i] = 0;
+    }
+}
@@ -0,0 +1,154 @@
+/**
+ * @file fft_cmsis_f32.c
+ * @brief FFT backend with the float real FFT of CMSIS-DSP (arm_rfft_fast_f32)
+ * @author Carl, 2024
+ */
+
+#include "fft_backend.h"
+
+#if (FFT_BACKEND == FFT_BACKEND_CMSIS_F32 && FFT_CLASSIFICATION) || FFT_COMPARE_CMSIS_F32
+
+#include "arm_math.h"
+#include "main.h"
+#include "window.h"
+#include <stdio.h>
+#include <string.h>
+
+//As reference for another backend, the functions get the fft_reference_ prefix
+#if FFT_BACKEND == FFT_BACKEND_CMSIS_F32
+#define FFT_F32(name) fft_##name
+#else
+#define FFT_F32(name) fft_reference_##name
+#endif
+
+//Float buffer for the FFT. It holds the windowed frame, then the spectrum and then the power of the bins.
+FFT_DATA float mic_buffer[INPUT_SIZE] = {0};
+#if FFT_IN_SRAM2
+//Copies of the CMSIS FFT tables for INPUT_SIZE. The real FFT of INPUT_SIZE uses a complex FFT of
+//INPUT_SIZE / 2, whose twiddle table has INPUT_SIZE floats, and its bit reversal table is shorter than INPUT_SIZE.
+FFT_DATA float32_t fft_twiddle_cfft[INPUT_SIZE];
+FFT_DATA float32_t fft_twiddle_rfft[INPUT_SIZE];
+FFT_DATA uint16_t fft_bit_reversal[INPUT_SIZE];
+#endif
+
+//Create a new arm_rfft_fast_instance_f32 and initialise it.
+arm_rfft_fast_instance_f32 S;
+
+
+#if FFT_IN_SRAM2
+//Copy the twiddle and bit reversal tables of the FFT from flash to SRAM2 and point the instance to the copies.
+//This avoids the flash wait states on the table reads in the FFT.
+static void Copy_fft_tables_to_sram2(arm_rfft_fast_instance_f32 *S) {
+    if (S->Sint.bitRevLength > INPUT_SIZE) {
+      printf("FFT bit reversal table does not fit.\r\n");
+      Error_Handler();
+    }
+    memcpy(fft_twiddle_cfft, S->Sint.pTwiddle, 2 * S->Sint.fftLen * sizeof(float32_t));
+    memcpy(fft_twiddle_rfft, S->pTwiddleRFFT, S->fftLenRFFT * sizeof(float32_t));
+    memcpy(fft_bit_reversal, S->Sint.pBitRevTable, S->Sint.bitRevLength * sizeof(uint16_t));
+    S->Sint.pTwiddle = fft_twiddle_cfft;
+    S->Sint.pBitRevTable = fft_bit_reversal;
+    S->pTwiddleRFFT = fft_twiddle_rfft;
+}
+#endif
+
+
+void FFT_F32(init)(void) {
+  // Initialize the CMSIS DSP FFT:
+  if (arm_rfft_fast_init_f32(&S, INPUT_SIZE) != ARM_MATH_SUCCESS) {
+        printf("FFT initialization failed.\r\n");
+        Error_Handler();
+    }
+#if FFT_IN_SRAM2
+  Copy_fft_tables_to_sram2(&S);
+#endif
+}
+
+
+//Scale and convert a frame from raw to float, remove its DC offset and apply the analysis window, into the
+//'mic_buffer' array. The FFT works in place, so the frame has to end up in 'mic_buffer' anyway to keep the
+//ring intact for the next overlapping frame; the window is applied on that copy.
+RAMFUNC void FFT_F32(load)(const mic_sample_t *frame, frame_stats_t *stats) {
+    // The pass over the raw samples for the level also finds the DC offset, instead of arm_mean_f32
+    fft_frame_stats(frame, stats);
+
+    // arm_q31_to_float scales by 1 / 2^31 and arm_q15_to_float by 1 / 2^15, which is the MIC_SCALE_FACTOR.
+    // Both kernels are unrolled by CMSIS and the multiplication runs in place.
+#if MIC_SAMPLES_16BIT
+    arm_q15_to_float((q15_t *)frame, mic_buffer, INPUT_SIZE);
+#else
+    arm_q31_to_float((q31_t *)frame, mic_buffer, INPUT_SIZE);
+#endif
+    // The window spreads the DC offset of the microphone into the bins next to 0 Hz, where the
+    // removal of the lowest 20Hz does not catch it anymore. So remove it before windowing.
+    arm_offset_f32(mic_buffer, -(float)stats->mean * (1.0f / 2147483648.0f), mic_buffer, INPUT_SIZE);
+    arm_mult_f32(mic_buffer, (float32_t *)analysis_window, mic_buffer, INPUT_SIZE);
+}
+
+
+RAMFUNC void FFT_F32(forward)(void) {
+    // The real-fft of INPUT_SIZE real samples will produce INPUT_SIZE/2 complex
+    // values, which require INPUT_SIZE floats to store. It runs in place.
+    arm_rfft_fast_f32(&S, mic_buffer, mic_buffer, 0);
+}
+
+
+RAMFUNC float* FFT_F32(power)(void) {
+    //Convert complex samples to real samples by taking the squared magnitude (no sqrt per bin):
+
+    // Note that the FFT_Buffer only contains INPUT_SIZE/2 complex values, which
+    // requires INPUT_SIZE floats.
+    arm_cmplx_mag_squared_f32(mic_buffer, mic_buffer, INPUT_SIZE / 2);
+
+    fft_remove_lowest_bins(mic_buffer);
+    return mic_buffer;
+}
+
+
+size_t FFT_F32(memory)(void) {
+#if FFT_IN_SRAM2
+    return sizeof(mic_buffer) + sizeof(fft_twiddle_cfft) + sizeof(fft_twiddle_rfft) + sizeof(fft_bit_reversal);
+#else
+    return sizeof(mic_buffer);
+#endif
+}
+
+
+#if FFT_BACKEND == FFT_BACKEND_CMSIS_F32
+void fft_benchmark(const mic_sample_t *frame) {
+    uint32_t start_scalar = DWT->CYCCNT;
+    for (int i = 0; i < INPUT_SIZE; i++) {
+      mic_buffer[i] = (float)frame[i] * MIC_SCALE_FACTOR;
+    }
+    uint32_t stop_scalar = DWT->CYCCNT;
+
+    frame_stats_t stats;
+    uint32_t start_cmsis = DWT->CYCCNT;
+    fft_load(frame, &stats);
+    uint32_t stop_cmsis = DWT->CYCCNT;
+
+    printf("Conversion of %d samples, scalar loop without window: %lu cycles\r\n", INPUT_SIZE,
+           (unsigned long)(stop_scalar - start_scalar));
+    printf("Conversion of %d samples, CMSIS with level and window: %lu cycles\r\n", INPUT_SIZE,
+           (unsigned long)(stop_cmsis - start_cmsis));
+
+    // Both kernels work in place, so each one gets a fresh spectrum
+    fft_forward();
+    uint32_t start_magnitude = DWT->CYCCNT;
+    arm_cmplx_mag_f32(mic_buffer, mic_buffer, INPUT_SIZE / 2);
+    uint32_t stop_magnitude = DWT->CYCCNT;
+
+    fft_load(frame, &stats);
+    fft_forward();
+    uint32_t start_power = DWT->CYCCNT;
+    fft_power();
+    uint32_t stop_power = DWT->CYCCNT;
+
+    printf("Spectrum of %d bins, magnitude: %lu cycles\r\n", INPUT_SIZE / 2,
+           (unsigned long)(stop_magnitude - start_magnitude));
+    printf("Spectrum of %d bins, power: %lu cycles\r\n", INPUT_SIZE / 2,
+           (unsigned long)(stop_power - start_power));
+}
+#endif
+
+#endif
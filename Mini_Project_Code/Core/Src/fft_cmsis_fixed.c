@@ -0,0 +1,107 @@
+/**
+ * @file fft_cmsis_fixed.c
+ * @brief FFT backend with the fixed-point real FFT of CMSIS-DSP (arm_rfft_q31 / arm_rfft_q15)
+ * @author Carl, 2024
+ */
+
+#include "fft_backend.h"
+
+#if (FFT_BACKEND == FFT_BACKEND_CMSIS_Q31 || FFT_BACKEND == FFT_BACKEND_CMSIS_Q15) && FFT_CLASSIFICATION
+
+#include "arm_math.h"
+#include "main.h"
+#include "window.h"
+#include <stdio.h>
+
+#if FFT_BACKEND == FFT_BACKEND_CMSIS_Q31
+typedef q31_t fft_fixed_t;
+arm_rfft_instance_q31 S_fixed;
+#else
+typedef q15_t fft_fixed_t;
+arm_rfft_instance_q15 S_fixed;
+#endif
+
+//Buffers of the fixed-point FFT, in SRAM1. The frame is scaled and windowed into 'fft_fixed_in', the real FFT
+//(which destroys its input) writes all INPUT_SIZE complex values into 'fft_fixed_out' and the power of the bins
+//goes back into 'fft_fixed_in'. It is converted to float into 'fft_fixed_power'.
+__attribute__((aligned(4))) fft_fixed_t fft_fixed_in[INPUT_SIZE];
+__attribute__((aligned(4))) fft_fixed_t fft_fixed_out[2 * INPUT_SIZE];
+float fft_fixed_power[INPUT_SIZE / 2];
+//Number of bits the loaded frame was shifted left by
+int fft_fixed_shift = 0;
+
+
+void fft_init(void) {
+#if FFT_BACKEND == FFT_BACKEND_CMSIS_Q31
+  if (arm_rfft_init_q31(&S_fixed, INPUT_SIZE, 0, 1) != ARM_MATH_SUCCESS) {
+#else
+  if (arm_rfft_init_q15(&S_fixed, INPUT_SIZE, 0, 1) != ARM_MATH_SUCCESS) {
+#endif
+        printf("Fixed-point FFT initialization failed.\r\n");
+        Error_Handler();
+    }
+}
+
+
+//Remove the DC offset of a frame, shift it up to the full range of the fixed-point format and apply the
+//analysis window, into 'fft_fixed_in'. A quiet frame keeps as many significant bits as a loud one.
+RAMFUNC void fft_load(const mic_sample_t *frame, frame_stats_t *stats) {
+    fft_frame_stats(frame, stats);
+    int32_t mean = stats->mean;
+    fft_fixed_shift = stats->block_exponent;
+
+#if FFT_BACKEND == FFT_BACKEND_CMSIS_Q31
+    q31_t *scaled = fft_fixed_in;
+#else
+    // The q15 output buffer has the size of INPUT_SIZE q31 values, use it for the q31 intermediate
+    q31_t *scaled = (q31_t *)fft_fixed_out;
+#endif
+#if MIC_SAMPLES_16BIT
+    arm_q15_to_q31((q15_t *)frame, scaled, INPUT_SIZE);
+    arm_offset_q31(scaled, -mean, scaled, INPUT_SIZE);
+#else
+    arm_offset_q31((q31_t *)frame, -mean, scaled, INPUT_SIZE);
+#endif
+    arm_shift_q31(scaled, fft_fixed_shift, scaled, INPUT_SIZE);
+#if FFT_BACKEND == FFT_BACKEND_CMSIS_Q31
+    arm_mult_q31(scaled, (q31_t *)analysis_window_q31, fft_fixed_in, INPUT_SIZE);
+#else
+    arm_q31_to_q15(scaled, fft_fixed_in, INPUT_SIZE);
+    arm_mult_q15(fft_fixed_in, (q15_t *)analysis_window_q15, fft_fixed_in, INPUT_SIZE);
+#endif
+}
+
+
+RAMFUNC void fft_forward(void) {
+#if FFT_BACKEND == FFT_BACKEND_CMSIS_Q31
+    arm_rfft_q31(&S_fixed, fft_fixed_in, fft_fixed_out);
+#else
+    arm_rfft_q15(&S_fixed, fft_fixed_in, fft_fixed_out);
+#endif
+}
+
+
+//The power has the same scale as the one of the float backend, so the classification is shared.
+RAMFUNC float* fft_power(void) {
+#if FFT_BACKEND == FFT_BACKEND_CMSIS_Q31
+    arm_cmplx_mag_squared_q31(fft_fixed_out, fft_fixed_in, INPUT_SIZE / 2);
+    arm_q31_to_float(fft_fixed_in, fft_fixed_power, INPUT_SIZE / 2);
+#else
+    arm_cmplx_mag_squared_q15(fft_fixed_out, fft_fixed_in, INPUT_SIZE / 2);
+    arm_q15_to_float(fft_fixed_in, fft_fixed_power, INPUT_SIZE / 2);
+#endif
+
+    // Undo the scaling in a single pass: the squared magnitude is in 3.29 (3.13) format, the real FFT scales
+    // its output down by INPUT_SIZE, the window table is halved and the frame was shifted left (all squared).
+    arm_scale_f32(fft_fixed_power, ldexpf(16.0f * INPUT_SIZE * INPUT_SIZE, -2 * fft_fixed_shift), fft_fixed_power, INPUT_SIZE / 2);
+
+    fft_remove_lowest_bins(fft_fixed_power);
+    return fft_fixed_power;
+}
+
+
+size_t fft_memory(void) {
+    return sizeof(fft_fixed_in) + sizeof(fft_fixed_out) + sizeof(fft_fixed_power);
+}
+
+#endif
@@ -0,0 +1,105 @@
+/**
+ * @file fft_kiss.c
+ * @brief FFT backend with kissfft (kiss_fftr), in float or in fixed point with FIXED_POINT 16 or 32
+ * @author Carl, 2024
+ */
+
+#include "fft_backend.h"
+
+#if FFT_BACKEND == FFT_BACKEND_KISS && FFT_CLASSIFICATION
+
+#include "kiss_fftr.h"
+#include "window.h"
+
+//Plain C without CMSIS and HAL headers, so this backend also builds on a host.
+//Error_Handler() is declared in main.h.
+void Error_Handler(void);
+
+//kiss_fftr allocates its configuration (twiddles and scratch buffers of the complex FFT of INPUT_SIZE / 2)
+//in this buffer instead of the heap. It needs 5/4 * INPUT_SIZE complex values and about 300 bytes for the state.
+__attribute__((aligned(8))) char fft_kiss_memory[sizeof(kiss_fft_cpx) * INPUT_SIZE * 5 / 4 + 512];
+kiss_fftr_cfg fft_kiss_cfg;
+//Windowed frame
+kiss_fft_scalar fft_kiss_in[INPUT_SIZE];
+//Spectrum of INPUT_SIZE / 2 + 1 bins, the power is computed in place
+union {
+    kiss_fft_cpx spectrum[INPUT_SIZE / 2 + 1];
+    float power[INPUT_SIZE / 2];
+} fft_kiss_out;
+#ifdef FIXED_POINT
+//Number of bits the loaded frame was shifted left by
+int fft_kiss_shift = 0;
+#endif
+
+
+void fft_init(void) {
+    size_t length = sizeof(fft_kiss_memory);
+    fft_kiss_cfg = kiss_fftr_alloc(INPUT_SIZE, 0, fft_kiss_memory, &length);
+    if (fft_kiss_cfg == NULL) {
+      printf("kissfft initialization failed, it needs %lu bytes.\r\n", (unsigned long)length);
+      Error_Handler();
+    }
+}
+
+
+//Remove the DC offset of the frame and apply the analysis window, into 'fft_kiss_in'.
+//In fixed point, the frame is also shifted up to the full range of the format first (block floating point).
+RAMFUNC void fft_load(const mic_sample_t *frame, frame_stats_t *stats) {
+    fft_frame_stats(frame, stats);
+#ifdef FIXED_POINT
+    int32_t mean = stats->mean;
+    fft_kiss_shift = stats->block_exponent;
+    for (int i = 0; i < INPUT_SIZE; i++) {
+      int64_t deviation = (int64_t)MIC_SAMPLE_TO_Q31(frame[i]) - mean;
+      int32_t sample = (int32_t)(fft_kiss_shift >= 0 ? deviation << fft_kiss_shift : deviation >> 1);
+#if FIXED_POINT == 32
+      fft_kiss_in[i] = (kiss_fft_scalar)(((int64_t)sample * analysis_window_q31[i]) >> 31);
+#else
+      fft_kiss_in[i] = (kiss_fft_scalar)(((sample >> 16) * analysis_window_q15[i]) >> 15);
+#endif
+    }
+#else
+    float mean = (float)stats->mean * (1.0f / 2147483648.0f);
+    for (int i = 0; i < INPUT_SIZE; i++) {
+      fft_kiss_in[i] = ((float)MIC_SAMPLE_TO_Q31(frame[i]) * (1.0f / 2147483648.0f) - mean) * analysis_window[i];
+    }
+#endif
+}
+
+
+RAMFUNC void fft_forward(void) {
+    kiss_fftr(fft_kiss_cfg, fft_kiss_in, fft_kiss_out.spectrum);
+}
+
+
+//The power has the same scale as the one of the CMSIS float backend.
+RAMFUNC float* fft_power(void) {
+#ifdef FIXED_POINT
+    // kissfft scales its output down by INPUT_SIZE in fixed point, the window table is halved
+    // and the frame was shifted left. The scale of the power is the square of that.
+#if FIXED_POINT == 32
+    float scale = ldexpf(2.0f * INPUT_SIZE, -31 - fft_kiss_shift);
+#else
+    float scale = ldexpf(2.0f * INPUT_SIZE, -15 - fft_kiss_shift);
+#endif
+    scale *= scale;
+#else
+    float scale = 1.0f;
+#endif
+    // Bin i of the power overlaps bins up to i of the spectrum, which were already read
+    for (int i = 0; i < INPUT_SIZE / 2; i++) {
+      float re = (float)fft_kiss_out.spectrum[i].r;
+      float im = (float)fft_kiss_out.spectrum[i].i;
+      fft_kiss_out.power[i] = (re * re + im * im) * scale;
+    }
+
+    fft_remove_lowest_bins(fft_kiss_out.power);
+    return fft_kiss_out.power;
+}
+
+
+size_t fft_memory(void) {
+    return sizeof(fft_kiss_memory) + sizeof(fft_kiss_in) + sizeof(fft_kiss_out);
+}
+
+#endif
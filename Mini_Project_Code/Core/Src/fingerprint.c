@@ -0,0 +1,117 @@
+/**
+ * @file fingerprint.c
+ * @brief Binary spectral fingerprints, matched against a library of templates of known sounds in flash
+ * @author Carl, 2024
+ */
+
+#include "fingerprint.h"
+#include "mel.h"
+#include <math.h>
+#include <stddef.h>
+
+//Start and end of the .fingerprints section, from the linker script
+extern const fingerprint_template_t _sfingerprints[];
+extern const fingerprint_template_t _efingerprints[];
+
+//First bin of every band, and the end of the last one
+int fingerprint_band_start[FINGERPRINT_BANDS + 1];
+//log2 of the bins of every band, to compare the power per bin of bands of different width
+float fingerprint_band_log_width[FINGERPRINT_BANDS];
+//Bits of the last FINGERPRINT_FRAMES frames; 'fingerprint_history_index' is the oldest one
+uint32_t fingerprint_history[FINGERPRINT_FRAMES];
+int fingerprint_history_index = 0;
+int fingerprint_history_count = 0;
+
+
+void fingerprint_init(void) {
+    int previous = 0;
+    for (int band = 0; band <= FINGERPRINT_BANDS; band++) {
+      float hz = FINGERPRINT_LOW_HZ * powf((FS / 2.0f) / FINGERPRINT_LOW_HZ, (float)band / FINGERPRINT_BANDS);
+      int bin = (int)(hz * INPUT_SIZE / FS + 0.5f);
+      // The low bands are narrower than a bin, every band gets at least one
+      if (band > 0 && bin <= previous) {
+        bin = previous + 1;
+      }
+      fingerprint_band_start[band] = bin;
+      previous = bin;
+    }
+    if (fingerprint_band_start[FINGERPRINT_BANDS] > INPUT_SIZE / 2) {
+      fingerprint_band_start[FINGERPRINT_BANDS] = INPUT_SIZE / 2;
+    }
+    for (int band = 0; band < FINGERPRINT_BANDS; band++) {
+      fingerprint_band_log_width[band] = log2f((float)(fingerprint_band_start[band + 1] - fingerprint_band_start[band]));
+    }
+}
+
+
+void fingerprint_reset(void) {
+    fingerprint_history_count = 0;
+}
+
+
+//The bit of a band is set if its log power per bin is above the mean of the bands. This keeps the shape of the
+//spectrum and drops the level, so the same sound matches near and far. Per bin, white noise is flat over the
+//bands and only the bands of the sound stand out.
+RAMFUNC uint32_t fingerprint_push(const float *spectrum) {
+    float log_energy[FINGERPRINT_BANDS];
+    float mean = 0;
+    for (int band = 0; band < FINGERPRINT_BANDS; band++) {
+      float energy = 1e-12f;
+      for (int bin = fingerprint_band_start[band]; bin < fingerprint_band_start[band + 1]; bin++) {
+        energy += spectrum[bin];
+      }
+      log_energy[band] = fast_log2f(energy) - fingerprint_band_log_width[band];
+      mean += log_energy[band];
+    }
+    mean /= FINGERPRINT_BANDS;
+
+    uint32_t bits = 0;
+    for (int band = 0; band < FINGERPRINT_BANDS; band++) {
+      bits |= (uint32_t)(log_energy[band] > mean) << band;
+    }
+
+    fingerprint_history[fingerprint_history_index] = bits;
+    fingerprint_history_index = (fingerprint_history_index + 1) % FINGERPRINT_FRAMES;
+    if (fingerprint_history_count < FINGERPRINT_FRAMES) {
+      fingerprint_history_count++;
+    }
+    return bits;
+}
+
+
+//The Cortex-M4 has no vector popcount, but all 32 bands of a frame are compared in one XOR of a word and
+//counted with the SWAR bit count of __builtin_popcount. The distance of a template only grows from word to
+//word, so it is dropped as soon as it reaches the best one so far; most templates are off after one word.
+RAMFUNC void fingerprint_match(fingerprint_result_t *result) {
+    result->match = NULL;
+    result->distance = FINGERPRINT_MAX_DISTANCE + 1;
+    result->compared_words = 0;
+    if (fingerprint_history_count < FINGERPRINT_FRAMES) {
+      return;
+    }
+
+    // The frames of the history in the order of a template, newest first, which is the most selective
+    uint32_t frames[FINGERPRINT_FRAMES];
+    for (int i = 0; i < FINGERPRINT_FRAMES; i++) {
+      frames[i] = fingerprint_history[(fingerprint_history_index + FINGERPRINT_FRAMES - 1 - i) % FINGERPRINT_FRAMES];
+    }
+
+    int compared_words = 0;
+    for (const fingerprint_template_t *template = _sfingerprints; template < _efingerprints; template++) {
+      int distance = 0;
+      for (int i = 0; i < FINGERPRINT_FRAMES && distance < result->distance; i++) {
+        distance += __builtin_popcount(frames[i] ^ template->bits[FINGERPRINT_FRAMES - 1 - i]);
+        compared_words++;
+      }
+      if (distance < result->distance) {
+        result->distance = distance;
+        result->match = template;
+      }
+    }
+    result->compared_words = compared_words;
+}
+
+
+int fingerprint_library_size(void) {
+    return (int)(_efingerprints - _sfingerprints);
+}
@@ -0,0 +1,24 @@
+/**
+ * @file fingerprint_library.c
+ * @brief Templates of known sounds for the fingerprint matching (fingerprint.h)
+ * @author Carl, 2024
+ */
+
+#include "fingerprint.h"
+
+//Frames of a template, oldest first. Record new ones with FINGERPRINT_RECORD in application.c, which prints the
+//fingerprint of every analysed frame, and copy FINGERPRINT_FRAMES consecutive ones of the sound.
+
+//Until recordings exist, the templates come from synthetic sounds with a little white noise, fingerprinted on a
+//host with the same code:
+//Mosquito: 2000Hz with two harmonics, frequency modulated by the wing beat (+-40Hz at 8Hz)
+FINGERPRINT_TEMPLATE fingerprint_mosquito = {
+    {0x2c600000, 0x24600000, 0x24600000, 0x24600000}, 4, "mosquito"};
+
+//Door chime: 1319Hz (E6) with two harmonics, not an intrusion
+FINGERPRINT_TEMPLATE fingerprint_chime = {
+    {0x048c0000, 0x048c0000, 0x048c0000, 0x048c0000}, 0, "chime"};
+
+//Hum of an appliance on the mains: 100Hz and its harmonics, not an intrusion
+FINGERPRINT_TEMPLATE fingerprint_mains_hum = {
+    {0x0001ffff, 0x0001ffff, 0x0001ffff, 0x0001ffff}, 0, "mains hum"};
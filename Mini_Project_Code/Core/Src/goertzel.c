@@ -0,0 +1,100 @@
+/**
+ * @file goertzel.c
+ * @brief Goertzel detector for the few frequencies the classification looks at, instead of a full FFT
+ * @author Carl, 2024
+ */
+
+#include "goertzel.h"
+#include "arm_math.h"
+
+//Probe frequencies in bins of a hop (FS / HOP_SIZE, 64Hz), spread over the bands of class_table.c:
+//voices (20Hz - 800Hz), foot steps (800Hz - 1700Hz), mosquito (1700Hz - 2800Hz) and glass break (above).
+//A frame has INPUT_SIZE / HOP_SIZE times as many bins, so the probes are on the same frequencies in both modes,
+//and every one of them lies inside its band: the top mosquito probe is bin 43 (2763Hz), bin 44 (2827Hz) would
+//already be glass break.
+//Every probe costs one multiply-add per sample, 18 probes on HOP_SIZE samples are still a fraction of the FFT.
+static const int goertzel_probe_hop_bin[GOERTZEL_PROBES] = {
+    2, 5, 7, 9, 12,       // 129Hz - 771Hz
+    14, 17, 20, 23,       // 899Hz - 1478Hz
+    30, 34, 39, 43,       // 1927Hz - 2763Hz
+    54, 70, 86, 101, 117, // 3469Hz - 7517Hz
+};
+
+#if GOERTZEL_STREAMING
+#define GOERTZEL_LENGTH HOP_SIZE
+#else
+#define GOERTZEL_LENGTH INPUT_SIZE
+#endif
+
+//Bins of the probes in GOERTZEL_LENGTH samples. On a whole bin, the DC offset and the other bins do not leak
+//into the probe.
+int goertzel_bin[GOERTZEL_PROBES];
+//2 * cos(2 * pi * bin / GOERTZEL_LENGTH)
+float goertzel_coefficient[GOERTZEL_PROBES];
+//Samples converted to float
+float goertzel_buffer[GOERTZEL_LENGTH];
+#if GOERTZEL_STREAMING
+//Power of every probe in the hops of the current frame, in the order of 'mic_ring'
+float goertzel_hop_power[INPUT_SIZE / HOP_SIZE][GOERTZEL_PROBES];
+int goertzel_hop_index = 0;
+#endif
+
+
+void goertzel_init(void) {
+    for (int i = 0; i < GOERTZEL_PROBES; i++) {
+      goertzel_bin[i] = goertzel_probe_hop_bin[i] * (GOERTZEL_LENGTH / HOP_SIZE);
+      goertzel_coefficient[i] = 2.0f * cosf(2.0f * PI * goertzel_bin[i] / GOERTZEL_LENGTH);
+    }
+}
+
+
+//Power of every probe in 'samples' (GOERTZEL_LENGTH samples), in the scale of an unnormalized DFT like the FFT.
+static RAMFUNC void goertzel_run(const mic_sample_t *samples, float *power) {
+#if MIC_SAMPLES_16BIT
+    arm_q15_to_float((q15_t *)samples, goertzel_buffer, GOERTZEL_LENGTH);
+#else
+    arm_q31_to_float((q31_t *)samples, goertzel_buffer, GOERTZEL_LENGTH);
+#endif
+
+    for (int i = 0; i < GOERTZEL_PROBES; i++) {
+      float coefficient = goertzel_coefficient[i];
+      float s1 = 0;
+      float s2 = 0;
+      for (int n = 0; n < GOERTZEL_LENGTH; n++) {
+        float s = goertzel_buffer[n] + coefficient * s1 - s2;
+        s2 = s1;
+        s1 = s;
+      }
+      power[i] = s1 * s1 + s2 * s2 - coefficient * s1 * s2;
+    }
+}
+
+
+#if GOERTZEL_STREAMING
+RAMFUNC void goertzel_push_hop(const mic_sample_t *hop) {
+    goertzel_run(hop, goertzel_hop_power[goertzel_hop_index]);
+    goertzel_hop_index = (goertzel_hop_index + 1) % (INPUT_SIZE / HOP_SIZE);
+}
+#endif
+
+
+RAMFUNC int32_t goertzel_dominant_frequency(const mic_sample_t *frame) {
+    float power[GOERTZEL_PROBES];
+#if GOERTZEL_STREAMING
+    // The frame is made of the last INPUT_SIZE / HOP_SIZE hops, which are all filtered already
+    (void)frame;
+    for (int i = 0; i < GOERTZEL_PROBES; i++) {
+      power[i] = 0;
+      for (int hop = 0; hop < INPUT_SIZE / HOP_SIZE; hop++) {
+        power[i] += goertzel_hop_power[hop][i];
+      }
+    }
+#else
+    goertzel_run(frame, power);
+#endif
+
+    float max_value;
+    uint32_t max_index;
+    arm_max_f32(power, GOERTZEL_PROBES, &max_value, &max_index);
+    return goertzel_bin[max_index] * FS / GOERTZEL_LENGTH;
+}
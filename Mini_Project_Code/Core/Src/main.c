@@ -40,6 +40,11 @@ UART_HandleTypeDef huart2;
 
 /* USER CODE BEGIN PV */
 volatile int mic_dma_finished_flag;
+volatile int mic_dma_half_finished_flag;
+volatile uint32_t mic_dma_overrun_count;
+volatile int mic_awd_triggered_flag;
+volatile int32_t mic_exd_max[2];
+volatile int32_t mic_exd_min[2];
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -324,10 +329,40 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
+// The DFSDM DMA runs in circular mode: the first half of the buffer is ready at the
+// half-transfer interrupt, the second half at the transfer-complete interrupt.
+// If a flag is still set when its half completes again, the application did not
+// consume that half in time and the block was overwritten.
+// The extremes detector is read (and thereby reset) at every half, so it holds
+// the highest and lowest sample of the half that has just been completed.
+void HAL_DFSDM_FilterRegConvHalfCpltCallback(DFSDM_Filter_HandleTypeDef *hdfsdm_filter) {
+  uint32_t channel;
+  mic_exd_max[0] = HAL_DFSDM_FilterGetExdMaxValue(hdfsdm_filter, &channel);
+  mic_exd_min[0] = HAL_DFSDM_FilterGetExdMinValue(hdfsdm_filter, &channel);
+  if (mic_dma_half_finished_flag) {
+    mic_dma_overrun_count++;
+  }
+  mic_dma_half_finished_flag = 1;
+}
+
 void HAL_DFSDM_FilterRegConvCpltCallback(DFSDM_Filter_HandleTypeDef *hdfsdm_filter) {
-  UNUSED(hdfsdm_filter);
+  uint32_t channel;
+  mic_exd_max[1] = HAL_DFSDM_FilterGetExdMaxValue(hdfsdm_filter, &channel);
+  mic_exd_min[1] = HAL_DFSDM_FilterGetExdMinValue(hdfsdm_filter, &channel);
+  if (mic_dma_finished_flag) {
+    mic_dma_overrun_count++;
+  }
   mic_dma_finished_flag = 1;
 }
+
+// The analog watchdog fired: the microphone level left the quiet window.
+// The watchdog is disarmed right away, otherwise it keeps firing for every loud sample.
+void HAL_DFSDM_FilterAwdCallback(DFSDM_Filter_HandleTypeDef *hdfsdm_filter, uint32_t Channel, uint32_t Threshold) {
+  UNUSED(Channel);
+  UNUSED(Threshold);
+  HAL_DFSDM_FilterAwdStop_IT(hdfsdm_filter);
+  mic_awd_triggered_flag = 1;
+}
 /* USER CODE END 4 */
 
 /**
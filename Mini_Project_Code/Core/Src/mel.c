@@ -0,0 +1,72 @@
+/**
+ * @file mel.c
+ * @brief Mel band energies and MFCCs of the power spectrum
+ * @author Carl, 2024
+ */
+
+#include "mel.h"
+#include "arm_math.h"
+#include "const_table.h"
+
+//The triangular filters are spaced evenly on the mel scale, at the band positions 0, 1, ..., MEL_BANDS + 1
+//between MEL_LOW_HZ and MEL_HIGH_HZ. Filter m rises from position m to m + 1 and falls back to 0 at m + 2.
+//So every bin lies on the rising edge of at most one filter and on the falling edge of the one before, and
+//the filter bank is stored sparse: per bin the filter whose rising edge it is on and the weight of that edge
+//(the falling edge has 1 - weight). The tables are computed by the compiler, see const_table.h.
+#define MEL(f) (2595.0 * __builtin_log10(1.0 + (f) / 700.0))
+#define MEL_POSITION(k) \
+    ((MEL((double)(k) * FS / INPUT_SIZE) - MEL(MEL_LOW_HZ)) / (MEL(MEL_HIGH_HZ) - MEL(MEL_LOW_HZ)) * (MEL_BANDS + 1))
+//Bins below MEL_LOW_HZ get band 0 and weight 0, so all of their power falls into the unused slot before the
+//first filter. The bins below MEL_HIGH_HZ stay below position MEL_BANDS + 1.
+#define MEL_BAND(k) (uint8_t)(MEL_POSITION(k) < 0 ? 0 : (int)MEL_POSITION(k))
+#define MEL_WEIGHT(k) (float)(MEL_POSITION(k) < 0 ? 0 : MEL_POSITION(k) - (int)MEL_POSITION(k))
+
+_Static_assert(MEL_BANDS < 255, "MEL_BANDS does not fit into the band table");
+_Static_assert(MEL_HIGH_HZ <= FS / 2, "MEL_HIGH_HZ must not be above the Nyquist frequency");
+
+static const uint8_t mel_band[INPUT_SIZE / 2] = {TABLE_BINS(MEL_BAND)};
+static const float mel_weight[INPUT_SIZE / 2] = {TABLE_BINS(MEL_WEIGHT)};
+
+#if MFCC_COEFFS
+//DCT-II matrix, MFCC_COEFFS rows of MEL_BANDS values
+float mfcc_dct[MFCC_COEFFS * MEL_BANDS];
+#endif
+
+
+void mel_init(void) {
+#if MFCC_COEFFS
+    for (int i = 0; i < MFCC_COEFFS; i++) {
+      for (int m = 0; m < MEL_BANDS; m++) {
+        mfcc_dct[i * MEL_BANDS + m] = cosf(PI * i * (m + 0.5f) / MEL_BANDS);
+      }
+    }
+#endif
+}
+
+
+RAMFUNC void mel_log_energies(const float *spectrum, float *log_energy) {
+    // Slot m + 1 holds filter m; slot 0 and slot MEL_BANDS + 1 catch the edges outside of the filter bank,
+    // so the loop needs no branch
+    float energy[MEL_BANDS + 2] = {0};
+    for (int k = 0; k < INPUT_SIZE / 2; k++) {
+      float power = spectrum[k];
+      float rising = mel_weight[k] * power;
+      int band = mel_band[k];
+      energy[band + 1] += rising;
+      energy[band] += power - rising;
+    }
+
+    // The offset keeps the log of an empty band finite
+    for (int m = 0; m < MEL_BANDS; m++) {
+      log_energy[m] = fast_logf(energy[m + 1] + 1e-12f);
+    }
+}
+
+
+#if MFCC_COEFFS
+RAMFUNC void mel_mfcc(const float *log_energy, float *mfcc) {
+    for (int i = 0; i < MFCC_COEFFS; i++) {
+      arm_dot_prod_f32((float32_t *)log_energy, &mfcc_dct[i * MEL_BANDS], MEL_BANDS, &mfcc[i]);
+    }
+}
+#endif
@@ -0,0 +1,154 @@
+/**
+ * @file mlp.c
+ * @brief int8 MLP over the log mel energies, with its weights in a blob in flash
+ * @author Carl, 2024
+ */
+
+#include "mlp.h"
+#include "arm_math.h"
+#include "main.h"
+#include <math.h>
+#include <string.h>
+
+//The blob from mlp_blob.S, see tools/mlp_blob.py for its layout
+extern const uint8_t mlp_blob[];
+extern const uint8_t mlp_blob_end[];
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t layer_count;
+    uint16_t inputs;
+    uint16_t reserved;
+} mlp_header_t;
+
+typedef struct {
+    uint16_t inputs;
+    uint16_t outputs;
+    uint8_t relu;
+    uint8_t reserved[3];
+    float requant;
+} mlp_layer_header_t;
+
+typedef struct {
+    const mlp_layer_header_t *header;
+    const int32_t *bias;
+    //Rows of 'header->inputs' weights, 4-byte aligned
+    const int8_t *weights;
+} mlp_layer_t;
+
+//Pointers into the blob, set by mlp_init
+const mlp_header_t *mlp_header = NULL;
+const float *mlp_input_offset = NULL;
+const float *mlp_input_scale = NULL;
+mlp_layer_t mlp_layers[MLP_MAX_LAYERS];
+
+//Activation arena: every layer reads one half and writes the other
+__attribute__((aligned(4))) int8_t mlp_arena[2][MLP_MAX_WIDTH];
+
+
+static void mlp_blob_error(const char *message) {
+    printf("MLP blob: %s\r\n", message);
+    Error_Handler();
+}
+
+
+void mlp_init(void) {
+    const uint8_t *position = mlp_blob;
+    mlp_header = (const mlp_header_t *)position;
+    if (mlp_blob_end - mlp_blob < (int)sizeof(mlp_header_t) || memcmp(mlp_header->magic, "MLP8", 4) != 0 ||
+        mlp_header->version != 1) {
+      mlp_blob_error("unknown format");
+    }
+    if (mlp_header->layer_count == 0 || mlp_header->layer_count > MLP_MAX_LAYERS || mlp_header->inputs > MLP_MAX_WIDTH) {
+      mlp_blob_error("too large");
+    }
+    if (mlp_header->inputs != MLP_INPUTS) {
+      mlp_blob_error("wrong number of inputs");
+    }
+    position += sizeof(mlp_header_t);
+    mlp_input_offset = (const float *)position;
+    position += mlp_header->inputs * sizeof(float);
+    mlp_input_scale = (const float *)position;
+    position += mlp_header->inputs * sizeof(float);
+
+    uint16_t inputs = (mlp_header->inputs + 3) & ~3;
+    for (int i = 0; i < mlp_header->layer_count; i++) {
+      const mlp_layer_header_t *header = (const mlp_layer_header_t *)position;
+      if (header->inputs != inputs || header->outputs > MLP_MAX_WIDTH) {
+        mlp_blob_error("layer sizes do not match");
+      }
+      mlp_layers[i].header = header;
+      position += sizeof(mlp_layer_header_t);
+      mlp_layers[i].bias = (const int32_t *)position;
+      position += header->outputs * sizeof(int32_t);
+      mlp_layers[i].weights = (const int8_t *)position;
+      position += (header->outputs * header->inputs + 3) & ~3;
+      inputs = (header->outputs + 3) & ~3;
+    }
+    if (position > mlp_blob_end || mlp_layers[mlp_header->layer_count - 1].header->outputs != MLP_CLASSES) {
+      mlp_blob_error("truncated or wrong number of classes");
+    }
+}
+
+
+//Dot product of 'length' (a multiple of 4) int8 values. The DSP extension of the Cortex-M4 multiplies
+//two pairs of 16-bit values per SMLAD: SXTB16 sign-extends bytes 0 and 2 of a word into two halfwords,
+//and bytes 1 and 3 after rotating it by 8 bits.
+static inline int32_t mlp_dot(const int8_t *weights, const int8_t *inputs, int length, int32_t sum) {
+#if defined(__ARM_FEATURE_DSP)
+    const uint32_t *w = (const uint32_t *)weights;
+    const uint32_t *x = (const uint32_t *)inputs;
+    for (int i = 0; i < length / 4; i++) {
+      uint32_t w4 = w[i];
+      uint32_t x4 = x[i];
+      sum = (int32_t)__SMLAD(__SXTB16(w4), __SXTB16(x4), (uint32_t)sum);
+      sum = (int32_t)__SMLAD(__SXTB16(__ROR(w4, 8)), __SXTB16(__ROR(x4, 8)), (uint32_t)sum);
+    }
+#else
+    for (int i = 0; i < length; i++) {
+      sum += weights[i] * inputs[i];
+    }
+#endif
+    return sum;
+}
+
+
+RAMFUNC int16_t mlp_classify(const float *inputs, float *scores) {
+    // Quantize the inputs into the arena, the padding stays zero
+    int8_t *x = mlp_arena[0];
+    uint16_t count = mlp_header->inputs;
+    memset(x, 0, (count + 3) & ~3);
+    for (int i = 0; i < count; i++) {
+      float q = roundf((inputs[i] - mlp_input_offset[i]) * mlp_input_scale[i]);
+      x[i] = (int8_t)(q > 127 ? 127 : q < -128 ? -128 : q);
+    }
+
+    int last = mlp_header->layer_count - 1;
+    for (int l = 0; l < last; l++) {
+      const mlp_layer_t *layer = &mlp_layers[l];
+      uint16_t outputs = layer->header->outputs;
+      int8_t *y = mlp_arena[(l + 1) & 1];
+      memset(y, 0, (outputs + 3) & ~3);
+      for (int o = 0; o < outputs; o++) {
+        int32_t sum = mlp_dot(&layer->weights[o * layer->header->inputs], x, layer->header->inputs, layer->bias[o]);
+        float q = roundf(sum * layer->header->requant);
+        if (layer->header->relu && q < 0) {
+          q = 0;
+        }
+        y[o] = (int8_t)(q > 127 ? 127 : q < -128 ? -128 : q);
+      }
+      x = y;
+    }
+
+    // The last layer gives the scores as float
+    const mlp_layer_t *layer = &mlp_layers[last];
+    for (int o = 0; o < MLP_CLASSES; o++) {
+      int32_t sum = mlp_dot(&layer->weights[o * layer->header->inputs], x, layer->header->inputs, layer->bias[o]);
+      scores[o] = sum * layer->header->requant;
+    }
+    float max_value;
+    uint32_t max_index;
+    arm_max_f32(scores, MLP_CLASSES, &max_value, &max_index);
+    return (int16_t)max_index;
+}
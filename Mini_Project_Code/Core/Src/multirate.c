@@ -0,0 +1,118 @@
+/**
+ * @file multirate.c
+ * @brief Stream decimated by 4 with its own small FFT, for the low bands (voices and foot steps)
+ * @author Carl, 2024
+ */
+
+#include "multirate.h"
+#include "arm_math.h"
+#include "const_table.h"
+#include "main.h"
+#include <string.h>
+
+#if LOW_INPUT_SIZE > 4096
+#error "arm_rfft_fast_f32 supports up to 4096 points, reduce LOW_INPUT_SIZE"
+#endif
+_Static_assert(HOP_SIZE % DECIMATION == 0, "HOP_SIZE must be a multiple of DECIMATION");
+_Static_assert(LOW_INPUT_SIZE % (HOP_SIZE / DECIMATION) == 0, "LOW_INPUT_SIZE must be a multiple of a decimated hop");
+
+//The tables are computed by the compiler, see const_table.h
+#define MULTIRATE_PI 3.14159265358979323846
+
+//Hamming windowed sinc lowpass with the -6dB point at 2000Hz, just below the new Nyquist frequency
+//(LOW_FS / 2 = 2056Hz). It passes the bands up to 1700Hz, and what aliases between 1700Hz and 2056Hz
+//comes from 2056Hz - 2412Hz, in the transition band. Above that, the window attenuates by > 40dB.
+#define DECIMATION_CUTOFF (2.0 * 2000.0 / FS)
+#define DECIMATION_X(n) ((n) - (DECIMATION_TAPS - 1) / 2.0)
+#define DECIMATION_TAP(n) \
+    (float)(DECIMATION_CUTOFF * __builtin_sin(MULTIRATE_PI * DECIMATION_CUTOFF * DECIMATION_X(n)) / \
+            (MULTIRATE_PI * DECIMATION_CUTOFF * DECIMATION_X(n)) * \
+            (0.54 - 0.46 * __builtin_cos(2.0 * MULTIRATE_PI * (n) / (DECIMATION_TAPS - 1))))
+#if DECIMATION_TAPS != 64
+#error "The decimation filter table has 64 taps"
+#endif
+static const float decimation_taps[DECIMATION_TAPS] = {TABLE_64(DECIMATION_TAP, 0)};
+
+//Hann window of LOW_INPUT_SIZE samples with a mean power of 1, like the analysis window
+#define LOW_WINDOW(n) (float)((0.5 - 0.5 * __builtin_cos(2.0 * MULTIRATE_PI * (n) / LOW_INPUT_SIZE)) / __builtin_sqrt(0.375))
+#if LOW_INPUT_SIZE != INPUT_SIZE / 2
+#error "The window of the decimated stream has INPUT_SIZE / 2 samples"
+#endif
+static const float low_window[LOW_INPUT_SIZE] = {TABLE_BINS(LOW_WINDOW)};
+
+arm_fir_decimate_instance_f32 S_decimate;
+float decimation_state[DECIMATION_TAPS + HOP_SIZE - 1];
+//Full-rate hop converted to float
+float decimation_input[HOP_SIZE];
+//Decimated stream, every sample stored twice like in 'mic_ring', so the newest frame is contiguous
+float low_ring[2 * LOW_INPUT_SIZE];
+int low_ring_index = 0;
+//Decimated samples since the last reset, up to MULTIRATE_READY_SAMPLES
+int low_samples = 0;
+//A whole frame after the DECIMATION_TAPS / DECIMATION outputs that the filter needs to fill its state. The
+//outputs before start from the zero state and step up to the DC offset of the microphone.
+#define MULTIRATE_READY_SAMPLES (LOW_INPUT_SIZE + DECIMATION_TAPS / DECIMATION)
+
+arm_rfft_fast_instance_f32 S_low;
+float low_buffer[LOW_INPUT_SIZE];
+
+
+void multirate_init(void) {
+    if (arm_fir_decimate_init_f32(&S_decimate, DECIMATION_TAPS, DECIMATION, (float32_t *)decimation_taps,
+                                  decimation_state, HOP_SIZE) != ARM_MATH_SUCCESS) {
+      printf("Decimation filter initialization failed.\r\n");
+      Error_Handler();
+    }
+    if (arm_rfft_fast_init_f32(&S_low, LOW_INPUT_SIZE) != ARM_MATH_SUCCESS) {
+      printf("Low band FFT initialization failed.\r\n");
+      Error_Handler();
+    }
+}
+
+
+void multirate_reset(void) {
+    memset(decimation_state, 0, sizeof(decimation_state));
+    memset(low_ring, 0, sizeof(low_ring));
+    low_ring_index = 0;
+    low_samples = 0;
+}
+
+
+RAMFUNC void multirate_push_hop(const mic_sample_t *hop) {
+#if MIC_SAMPLES_16BIT
+    arm_q15_to_float((q15_t *)hop, decimation_input, HOP_SIZE);
+#else
+    arm_q31_to_float((q31_t *)hop, decimation_input, HOP_SIZE);
+#endif
+    // Only every DECIMATION-th output of the filter is computed
+    float *low_hop = &low_ring[low_ring_index];
+    arm_fir_decimate_f32(&S_decimate, decimation_input, low_hop, HOP_SIZE);
+    memcpy(low_hop + LOW_INPUT_SIZE, low_hop, HOP_SIZE / DECIMATION * sizeof(float));
+    low_ring_index = (low_ring_index + HOP_SIZE / DECIMATION) % LOW_INPUT_SIZE;
+    if (low_samples < MULTIRATE_READY_SAMPLES) {
+      low_samples += HOP_SIZE / DECIMATION;
+    }
+}
+
+
+int multirate_low_ready(void) {
+    return low_samples >= MULTIRATE_READY_SAMPLES;
+}
+
+
+RAMFUNC float* multirate_low_power(void) {
+    // Remove the DC offset and window the newest frame, like the full-rate frames
+    float mean;
+    arm_mean_f32(&low_ring[low_ring_index], LOW_INPUT_SIZE, &mean);
+    arm_offset_f32(&low_ring[low_ring_index], -mean, low_buffer, LOW_INPUT_SIZE);
+    arm_mult_f32(low_buffer, (float32_t *)low_window, low_buffer, LOW_INPUT_SIZE);
+
+    arm_rfft_fast_f32(&S_low, low_buffer, low_buffer, 0);
+    arm_cmplx_mag_squared_f32(low_buffer, low_buffer, LOW_INPUT_SIZE / 2);
+
+    //remove the lowest 20Hz
+    for (int i = 0; i < 20 * LOW_INPUT_SIZE / LOW_FS; i++) {
+      low_buffer[i] = 0;
+    }
+    return low_buffer;
+}
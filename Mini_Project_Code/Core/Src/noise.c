@@ -0,0 +1,22 @@
+/**
+ * @file noise.c
+ * @brief Running noise floor of every bin and spectral subtraction
+ * @author Carl, 2024
+ */
+
+#include "noise.h"
+
+
+RAMFUNC void noise_subtract(float *spectrum, float *noise_floor, int bins) {
+    for (int k = 0; k < bins; k++) {
+      float power = spectrum[k];
+      float floor = noise_floor[k];
+
+      // Subtract the floor of the previous frames, so a sound does not subtract itself
+      float clean = power - NOISE_OVERSUBTRACTION * floor;
+      float minimum = NOISE_SPECTRAL_FLOOR * power;
+      spectrum[k] = clean > minimum ? clean : minimum;
+
+      noise_floor[k] = floor + (power < floor ? NOISE_FALL : NOISE_RISE) * (power - floor);
+    }
+}
@@ -0,0 +1,35 @@
+/**
+ * @file onset.c
+ * @brief Onset detector on the spectral flux, with a threshold that adapts to the recent frames
+ * @author Carl, 2024
+ */
+
+#include "onset.h"
+
+//Flux of the last ONSET_HISTORY frames (0 after silence) and their sum
+float onset_history[ONSET_HISTORY] = {0};
+float onset_history_sum = 0;
+int onset_history_index = 0;
+
+
+void onset_reset(void) {
+    for (int i = 0; i < ONSET_HISTORY; i++) {
+      onset_history[i] = 0;
+    }
+    onset_history_sum = 0;
+}
+
+
+RAMFUNC int onset_detect(float flux) {
+    float threshold = ONSET_FACTOR * onset_history_sum / ONSET_HISTORY;
+    if (threshold < ONSET_MIN_FLUX) {
+      threshold = ONSET_MIN_FLUX;
+    }
+
+    // Update the running sum instead of summing the history again
+    onset_history_sum += flux - onset_history[onset_history_index];
+    onset_history[onset_history_index] = flux;
+    onset_history_index = (onset_history_index + 1) % ONSET_HISTORY;
+
+    return flux > threshold;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file spectral_features.c
+ * @brief Spectral descriptors of a frame, computed in one pass over the power spectrum
+ * @author Carl, 2024
+ */
+
+#include "spectral_features.h"
+#include "mel.h"
+#include <math.h>
+
+//First bin of each band and the end of the last one
+static const int feature_band_edges[FEATURE_BANDS + 1] = {
+    20 * INPUT_SIZE / FS,
+    800 * INPUT_SIZE / FS,
+    1700 * INPUT_SIZE / FS,
+    2800 * INPUT_SIZE / FS,
+    INPUT_SIZE / 2,
+};
+
+//The cumulative power is kept every ROLLOFF_BLOCK bins, so the rolloff only needs to look at one block again
+#define ROLLOFF_BLOCK 16
+_Static_assert((INPUT_SIZE / 2) % ROLLOFF_BLOCK == 0, "INPUT_SIZE / 2 must be a multiple of ROLLOFF_BLOCK");
+
+
+RAMFUNC void spectral_features(const float *spectrum, float *previous, spectral_features_t *features) {
+    float cumulative_power[INPUT_SIZE / 2 / ROLLOFF_BLOCK] = {0};
+    float total = 0;
+    float weighted_bins = 0;
+    float weighted_squared_bins = 0;
+    float log_sum = 0;
+    float flux = 0;
+    float max_power = -1;
+    int max_bin = 0;
+
+    // The bins are visited band by band, so every value is read once and the band needs no lookup
+    for (int band = 0; band < FEATURE_BANDS; band++) {
+      float band_power = 0;
+      for (int k = feature_band_edges[band]; k < feature_band_edges[band + 1]; k++) {
+        float power = spectrum[k];
+        band_power += power;
+        weighted_bins += power * k;
+        weighted_squared_bins += power * k * k;
+        log_sum += fast_log2f(power + 1e-20f);
+        float increase = power - previous[k];
+        flux += increase > 0 ? increase : 0;
+        previous[k] = power;
+        if (power > max_power) {
+          max_power = power;
+          max_bin = k;
+        }
+        if (k % ROLLOFF_BLOCK == ROLLOFF_BLOCK - 1) {
+          cumulative_power[k / ROLLOFF_BLOCK] = total + band_power;
+        }
+      }
+      features->band_energy[band] = band_power;
+      total += band_power;
+    }
+
+    features->total_power = total;
+    features->dominant_frequency = max_bin * FS / INPUT_SIZE;
+    if (total <= 0) {
+      features->centroid = 0;
+      features->bandwidth = 0;
+      features->rolloff = 0;
+      features->flatness = 0;
+      features->flux = 0;
+      return;
+    }
+
+    float bin_to_hz = (float)FS / INPUT_SIZE;
+    float centroid = weighted_bins / total;
+    float variance = weighted_squared_bins / total - centroid * centroid;
+    features->centroid = centroid * bin_to_hz;
+    features->bandwidth = variance > 0 ? sqrtf(variance) * bin_to_hz : 0;
+    for (int band = 0; band < FEATURE_BANDS; band++) {
+      features->band_energy[band] /= total;
+    }
+
+    int bins = feature_band_edges[FEATURE_BANDS] - feature_band_edges[0];
+    features->flatness = exp2f(log_sum / bins) / (total / bins);
+    features->flux = flux / total;
+
+    // Find the block in which the cumulative power crosses the rolloff, and the bin inside of it
+    // ('previous' holds this spectrum by now)
+    float rolloff_power = ROLLOFF_PERCENT * total;
+    int block = 0;
+    while (block < INPUT_SIZE / 2 / ROLLOFF_BLOCK - 1 && cumulative_power[block] < rolloff_power) {
+      block++;
+    }
+    float cumulative = block > 0 ? cumulative_power[block - 1] : 0;
+    int k = block * ROLLOFF_BLOCK;
+    while (k < (block + 1) * ROLLOFF_BLOCK - 1) {
+      cumulative += previous[k];
+      if (cumulative >= rolloff_power) {
+        break;
+      }
+      k++;
+    }
+    features->rolloff = k * bin_to_hz;
+}
@@ -0,0 +1,46 @@
+/**
+ * @file spectral_peaks.c
+ * @brief Strongest peaks of a power spectrum with sub-bin frequency and power
+ * @author Carl, 2024
+ */
+
+#include "spectral_peaks.h"
+#include "mel.h"
+#include <math.h>
+
+
+RAMFUNC int spectral_peaks(const float *spectrum, int bins, float bin_hz, spectral_peak_t *peaks) {
+    // Keep the strongest local maxima sorted in 'peaks' while scanning: a new one is only inserted if it beats
+    // the weakest one kept, so there is no sort and the list is rarely touched
+    int count = 0;
+    for (int k = 1; k < bins - 1; k++) {
+      float power = spectrum[k];
+      if (power <= spectrum[k - 1] || power < spectrum[k + 1]) {
+        continue;
+      }
+      if (count == PEAKS_K && power <= peaks[PEAKS_K - 1].power) {
+        continue;
+      }
+      int i = count < PEAKS_K ? count++ : PEAKS_K - 1;
+      while (i > 0 && peaks[i - 1].power < power) {
+        peaks[i] = peaks[i - 1];
+        i--;
+      }
+      peaks[i].power = power;
+      peaks[i].bin = k;
+    }
+
+    // Fit a parabola through the log power of the peak and its neighbours. The main lobe of the window
+    // is close to a parabola on a log scale, so this is more accurate than on the power itself.
+    for (int i = 0; i < count; i++) {
+      int k = peaks[i].bin;
+      float left = fast_log2f(spectrum[k - 1] + 1e-20f);
+      float centre = fast_log2f(spectrum[k] + 1e-20f);
+      float right = fast_log2f(spectrum[k + 1] + 1e-20f);
+      float curvature = left - 2.0f * centre + right;
+      float offset = curvature < 0 ? 0.5f * (left - right) / curvature : 0;
+      peaks[i].frequency = (k + offset) * bin_hz;
+      peaks[i].power = exp2f(centre - 0.25f * (left - right) * offset);
+    }
+    return count;
+}
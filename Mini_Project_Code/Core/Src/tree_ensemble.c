@@ -0,0 +1,49 @@
+/**
+ * @file tree_ensemble.c
+ * @brief Evaluator for tree ensembles generated into flash by tools/tree_codegen.py
+ * @author Carl, 2024
+ */
+
+#include "tree_ensemble.h"
+
+
+RAMFUNC int16_t tree_ensemble_classify(const spectral_features_t *features, float *scores) {
+    float x[TREE_FEATURES];
+    x[TREE_FEATURE_TOTAL_POWER] = features->total_power;
+    x[TREE_FEATURE_DOMINANT_FREQUENCY] = (float)features->dominant_frequency;
+    x[TREE_FEATURE_CENTROID] = features->centroid;
+    x[TREE_FEATURE_BANDWIDTH] = features->bandwidth;
+    x[TREE_FEATURE_ROLLOFF] = features->rolloff;
+    x[TREE_FEATURE_FLATNESS] = features->flatness;
+    x[TREE_FEATURE_FLUX] = features->flux;
+    x[TREE_FEATURE_PEAK_LEVEL] = features->peak_level;
+    x[TREE_FEATURE_CREST_FACTOR] = features->crest_factor;
+    x[TREE_FEATURE_ZERO_CROSSING_RATE] = features->zero_crossing_rate;
+    for (int band = 0; band < FEATURE_BANDS; band++) {
+      x[TREE_FEATURE_BAND_ENERGY + band] = features->band_energy[band];
+    }
+
+    for (int c = 0; c < TREE_CLASSES; c++) {
+      scores[c] = 0;
+    }
+    for (int t = 0; t < tree_count; t++) {
+      int i = tree_roots[t];
+      // The only branch is the loop; the next node is a conditional select (IT block), not a jump
+      while (tree_nodes[i].feature != TREE_LEAF) {
+        const tree_node_t *node = &tree_nodes[i];
+        i = x[node->feature] <= node->threshold ? i + 1 : node->right;
+      }
+      const float *leaf = &tree_leaf_scores[tree_nodes[i].right * TREE_CLASSES];
+      for (int c = 0; c < TREE_CLASSES; c++) {
+        scores[c] += leaf[c];
+      }
+    }
+
+    int16_t best = 0;
+    for (int c = 1; c < TREE_CLASSES; c++) {
+      if (scores[c] > scores[best]) {
+        best = c;
+      }
+    }
+    return best;
+}
@@ -0,0 +1,37 @@
+/**
+ * @file tree_model.c
+ * @brief Tree ensemble for tree_ensemble.c, generated by tools/tree_codegen.py from --band-rule
+ * @author Carl, 2024
+ */
+
+//Generated, do not edit. 1 trees, 9 nodes, 5 leaves, 174 bytes of flash.
+//Worst case 3 nodes per frame, about 124 cycles.
+
+#include "tree_ensemble.h"
+
+//{threshold, right child or leaf, feature, reserved}
+const tree_node_t tree_nodes[] = {
+    {799.0f, 4, TREE_FEATURE_DOMINANT_FREQUENCY, 0},
+    {19.0f, 3, TREE_FEATURE_DOMINANT_FREQUENCY, 0},
+    {0.0f, 0, TREE_LEAF, 0},
+    {0.0f, 1, TREE_LEAF, 0},
+    {1699.0f, 6, TREE_FEATURE_DOMINANT_FREQUENCY, 0},
+    {0.0f, 2, TREE_LEAF, 0},
+    {2799.0f, 8, TREE_FEATURE_DOMINANT_FREQUENCY, 0},
+    {0.0f, 3, TREE_LEAF, 0},
+    {0.0f, 4, TREE_LEAF, 0},
+};
+
+const uint16_t tree_roots[] = {0};
+
+const float tree_leaf_scores[] = {
+    1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+    0.0f, 1.0f, 0.0f, 0.0f, 0.0f,
+};
+
+const int tree_count = 1;
+const int tree_leaf_kind = TREE_LEAVES_VOTES;
+const int tree_worst_case_nodes = 3;
@@ -0,0 +1,32 @@
+/**
+ * @file window.c
+ * @brief Analysis window applied to every frame before the FFT
+ * @author Carl, 2024
+ */
+
+#include "window.h"
+#include "const_table.h"
+
+//The table is computed by the compiler, see const_table.h
+#define WINDOW_PI 3.14159265358979323846
+
+#if WINDOW_HANN
+#define WINDOW_A0 0.5
+#define WINDOW_A1 0.5
+#else
+#define WINDOW_A0 0.54
+#define WINDOW_A1 0.46
+#endif
+
+//Mean power of the raised cosine a0 - a1 * cos(x) is a0^2 + a1^2 / 2
+#define WINDOW_GAIN __builtin_sqrt(WINDOW_A0 * WINDOW_A0 + WINDOW_A1 * WINDOW_A1 / 2.0)
+#define WINDOW(n) ((WINDOW_A0 - WINDOW_A1 * __builtin_cos(2.0 * WINDOW_PI * (n) / INPUT_SIZE)) / WINDOW_GAIN)
+
+//The fixed-point tables hold half of the window, its maximum (up to 1.63) does not fit into q31/q15
+#define WINDOW_F32(n) (float)WINDOW(n)
+#define WINDOW_Q31(n) (int32_t)(WINDOW(n) * 0.5 * 2147483648.0 + 0.5)
+#define WINDOW_Q15(n) (int16_t)(WINDOW(n) * 0.5 * 32768.0 + 0.5)
+
+const float analysis_window[INPUT_SIZE] = {TABLE_INPUT_SIZE(WINDOW_F32)};
+const int32_t analysis_window_q31[INPUT_SIZE] = {TABLE_INPUT_SIZE(WINDOW_Q31)};
+const int16_t analysis_window_q15[INPUT_SIZE] = {TABLE_INPUT_SIZE(WINDOW_Q15)};
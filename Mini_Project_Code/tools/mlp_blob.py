@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""
+@file mlp_blob.py
+@brief Quantize a small MLP to int8 and write the weight blob that mlp.c reads from flash
+@author Carl, 2024
+
+Usage:
+  python3 tools/mlp_blob.py model.json Core/Model/mlp_weights.bin
+  python3 tools/mlp_blob.py --band-rule Core/Model/mlp_weights.bin
+
+model.json holds the float model over the MEL_BANDS log mel energies (natural log, see mel.h), followed by the
+LEVEL_INPUTS of the frame level: natural log of the peak level, natural log of the crest factor and the zero
+crossing rate (see MLP_INPUTS in mlp.h):
+  {
+    "input_mean": [...], "input_std": [...],          one value per input
+    "layers": [
+      {"weights": [[...], ...], "bias": [...],       one row of inputs per output
+       "relu": true, "output_range": 8.0},           range of the outputs for the int8 activations
+      ...
+    ]
+  }
+The last layer has one output per classification (0 - 4, see application.c) and no ReLU.
+
+--band-rule writes a model without training: one hidden unit per class band averages the log energies of
+the mel bands in it, and the band with the highest average wins. The level inputs get no weight. It stands in until trained weights exist.
+
+Blob layout (little endian, every part a multiple of 4 bytes):
+  char magic[4] "MLP8", uint16 version 1, uint16 layer count, uint16 inputs, uint16 0
+  float offset[inputs], float scale[inputs]       q = round((x - offset) * scale)
+  per layer:
+    uint16 inputs (padded to a multiple of 4), uint16 outputs, uint8 relu, uint8 0[3]
+    float requant                                 accumulator * requant = int8 output (float for the last layer)
+    int32 bias[outputs]
+    int8 weights[outputs][padded inputs]
+"""
+
+import json
+import math
+import struct
+import sys
+
+# Keep in sync with mel.h, mlp.h and application.h
+MEL_BANDS = 26
+LEVEL_INPUTS = 3
+MEL_LOW_HZ = 20
+FS = 16447
+CLASSES = 5
+# The normalized inputs are quantized over +-INPUT_RANGE standard deviations
+INPUT_RANGE = 4.0
+
+
+def pad4(n):
+    return (n + 3) // 4 * 4
+
+
+def quantize(value, scale, low, high):
+    return max(low, min(high, int(round(value / scale))))
+
+
+def band_rule_model():
+    def mel(f):
+        return 2595.0 * math.log10(1.0 + f / 700.0)
+
+    def hz(m):
+        return 700.0 * (10.0 ** (m / 2595.0) - 1.0)
+
+    # Centre of mel filter m is at position m + 1 of MEL_BANDS + 1
+    low, high = mel(MEL_LOW_HZ), mel(FS / 2)
+    centres = [hz(low + (m + 1) * (high - low) / (MEL_BANDS + 1)) for m in range(MEL_BANDS)]
+    # Class bands in the order of the hidden units, with their classification
+    bands = [(0, 800, 3), (800, 1700, 2), (1700, 2800, 4), (2800, FS, 1)]
+
+    hidden_weights = []
+    for low_hz, high_hz, _ in bands:
+        members = [m for m, f in enumerate(centres) if low_hz <= f < high_hz]
+        hidden_weights.append([1.0 / len(members) if m in members else 0.0 for m in range(MEL_BANDS)] +
+                              [0.0] * LEVEL_INPUTS)
+    # Log energies are roughly within +-32, the shift keeps the averages positive through the ReLU
+    hidden_bias = [INPUT_RANGE] * len(bands)
+
+    output_weights = [[0.0] * len(bands) for _ in range(CLASSES)]
+    output_bias = [0.0] * CLASSES
+    output_bias[0] = -2.0 * INPUT_RANGE
+    for unit, (_, _, classification) in enumerate(bands):
+        output_weights[classification][unit] = 1.0
+
+    return {
+        # The peak level is between about 1e-4 and 1, the crest factor between 1.4 and 10
+        "input_mean": [0.0] * MEL_BANDS + [-4.5, 1.0, 0.25],
+        "input_std": [8.0] * MEL_BANDS + [2.5, 0.5, 0.25],
+        "layers": [
+            {"weights": hidden_weights, "bias": hidden_bias, "relu": True, "output_range": 2.0 * INPUT_RANGE},
+            {"weights": output_weights, "bias": output_bias, "relu": False},
+        ],
+    }
+
+
+def write_blob(model, path):
+    inputs = len(model["input_mean"])
+    if inputs != MEL_BANDS + LEVEL_INPUTS:
+        sys.exit("The model needs %d inputs" % (MEL_BANDS + LEVEL_INPUTS))
+    layers = model["layers"]
+    if len(layers[-1]["bias"]) != CLASSES:
+        sys.exit("The last layer needs %d outputs" % CLASSES)
+
+    input_scale = INPUT_RANGE / 127.0
+    blob = struct.pack("<4sHHHH", b"MLP8", 1, len(layers), inputs, 0)
+    blob += struct.pack("<%df" % inputs, *model["input_mean"])
+    blob += struct.pack("<%df" % inputs, *[1.0 / (s * input_scale) for s in model["input_std"]])
+
+    for index, layer in enumerate(layers):
+        weights = layer["weights"]
+        outputs = len(weights)
+        layer_inputs = len(weights[0])
+        padded = pad4(layer_inputs)
+        last = index == len(layers) - 1
+
+        weight_scale = max(abs(w) for row in weights for w in row) / 127.0 or 1.0
+        accumulator_scale = input_scale * weight_scale
+        output_scale = 1.0 if last else layer["output_range"] / 127.0
+        requant = accumulator_scale / output_scale
+
+        blob += struct.pack("<HHB3x", padded, outputs, 1 if layer.get("relu") else 0)
+        blob += struct.pack("<f", requant)
+        blob += struct.pack("<%di" % outputs, *[int(round(b / accumulator_scale)) for b in layer["bias"]])
+        for row in weights:
+            quantized = [quantize(w, weight_scale, -127, 127) for w in row] + [0] * (padded - layer_inputs)
+            blob += struct.pack("<%db" % padded, *quantized)
+        blob += b"\0" * (pad4(len(blob)) - len(blob))
+        input_scale = output_scale
+
+    with open(path, "wb") as f:
+        f.write(blob)
+    print("%s: %d bytes, %d layers" % (path, len(blob), len(layers)))
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    if sys.argv[1] == "--band-rule":
+        model = band_rule_model()
+    else:
+        with open(sys.argv[1]) as f:
+            model = json.load(f)
+    write_blob(model, sys.argv[2])
+
+
+if __name__ == "__main__":
+    main()
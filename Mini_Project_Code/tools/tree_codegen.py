@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""
+@file tree_codegen.py
+@brief Generate the flash tables of a tree ensemble for tree_ensemble.c from a trained model
+@author Carl, 2024
+
+Usage:
+  python3 tools/tree_codegen.py model.json Core/Src/tree_model.c
+  python3 tools/tree_codegen.py --band-rule Core/Src/tree_model.c
+
+model.json holds the trees over the spectral features (spectral_features.h), by the names in FEATURE_NAMES:
+  {
+    "leaves": "votes",                                        or "logits", see below
+    "trees": [
+      {"feature": "dominant_frequency", "threshold": 800,    inner node: feature <= threshold goes left
+       "left": {...}, "right": {...}},
+      {"scores": [s0, s1, s2, s3, s4]}                        leaf: one score per classification (0 - 4)
+      {"class": 3}                                            leaf: one vote for a classification
+    ]
+  }
+The scores of the leaves a frame ends in are added up over all trees. "leaves" tells the firmware what the
+sums are: "votes" (the default) for votes or probabilities of a random forest, which must not be negative and
+are divided by the number of trees, "logits" for gradient boosted trees (e.g. XGBoost), whose sums go through a
+softmax. Scikit-learn and XGBoost dumps convert to this with a few lines of the nested dict above.
+
+--band-rule writes a single tree without training that splits the dominant frequency at the edges of the
+class bands, like class_table.c. It stands in until a trained ensemble exists.
+
+The nodes of all trees go into one array, each tree depth first so the left child follows its parent in
+flash. The generator prints the worst case of nodes a frame visits and an estimate of its cycles.
+"""
+
+import json
+import sys
+
+# Keep in sync with the TREE_FEATURE_ enum in tree_ensemble.h and application.c
+FEATURE_BANDS = 4
+FEATURE_NAMES = ["total_power", "dominant_frequency", "centroid", "bandwidth", "rolloff", "flatness", "flux",
+                 "peak_level", "crest_factor", "zero_crossing_rate"] + \
+    ["band_energy_%d" % band for band in range(FEATURE_BANDS)]
+CLASSES = 5
+TREE_LEAF = 0xFF
+LEAF_KINDS = {"votes": "TREE_LEAVES_VOTES", "logits": "TREE_LEAVES_LOGITS"}
+# Estimated cycles on the Cortex-M4 with the tables in flash behind the ART cache: load of the node, the
+# feature and the threshold, compare, conditional select and the loop per inner node, then the additions of
+# the scores per leaf, and the features and the argmax once per frame.
+CYCLES_PER_NODE = 12
+CYCLES_PER_LEAF = 8 + 4 * CLASSES
+CYCLES_PER_FRAME = 40 + 4 * CLASSES
+
+
+def band_rule_model():
+    def split(threshold, left, right):
+        return {"feature": "dominant_frequency", "threshold": threshold, "left": left, "right": right}
+
+    def leaf(classification):
+        return {"class": classification}
+
+    # Balanced over the band edges of class_table.c: none below 20Hz, voices, footsteps, mosquito, glass.
+    # The thresholds are the last frequency of the lower band, as a frequency equal to them goes left.
+    return {"trees": [
+        split(799, split(19, leaf(0), leaf(3)), split(1699, leaf(2), split(2799, leaf(4), leaf(1)))),
+    ]}
+
+
+def leaf_scores(node):
+    if "scores" in node:
+        if len(node["scores"]) != CLASSES:
+            sys.exit("A leaf needs %d scores" % CLASSES)
+        return [float(s) for s in node["scores"]]
+    scores = [0.0] * CLASSES
+    scores[int(node["class"])] = 1.0
+    return scores
+
+
+def flatten(tree, nodes, leaves):
+    """Append the nodes of 'tree' depth first, returns the depth of its deepest leaf."""
+    index = len(nodes)
+    if "feature" not in tree:
+        nodes.append((0.0, len(leaves), TREE_LEAF))
+        leaves.append(leaf_scores(tree))
+        return 0
+    if tree["feature"] not in FEATURE_NAMES:
+        sys.exit("Unknown feature %s, expected one of %s" % (tree["feature"], ", ".join(FEATURE_NAMES)))
+    nodes.append(None)
+    left_depth = flatten(tree["left"], nodes, leaves)
+    right = len(nodes)
+    right_depth = flatten(tree["right"], nodes, leaves)
+    nodes[index] = (float(tree["threshold"]), right, FEATURE_NAMES.index(tree["feature"]))
+    return 1 + max(left_depth, right_depth)
+
+
+def c_float(value):
+    text = repr(float(value))
+    return (text if "e" in text or "." in text else text + ".0") + "f"
+
+
+def write_model(model, path, source):
+    kind = model.get("leaves", "votes")
+    if kind not in LEAF_KINDS:
+        sys.exit("Unknown leaves %s, expected one of %s" % (kind, ", ".join(LEAF_KINDS)))
+    nodes, leaves, roots, depths = [], [], [], []
+    for tree in model["trees"]:
+        roots.append(len(nodes))
+        depths.append(flatten(tree, nodes, leaves))
+    if kind == "votes" and any(s < 0 for scores in leaves for s in scores):
+        sys.exit("Leaves with votes cannot be negative, use \"leaves\": \"logits\"")
+    if len(nodes) > 0xFFFF or len(leaves) > 0xFFFF:
+        sys.exit("More than 65535 nodes do not fit into the uint16_t indices")
+
+    worst_case_nodes = sum(depths)
+    cycles = worst_case_nodes * CYCLES_PER_NODE + len(roots) * CYCLES_PER_LEAF + CYCLES_PER_FRAME
+    flash = len(nodes) * 8 + len(roots) * 2 + len(leaves) * CLASSES * 4
+
+    lines = [
+        "/**",
+        " * @file tree_model.c",
+        " * @brief Tree ensemble for tree_ensemble.c, generated by tools/tree_codegen.py from %s" % source,
+        " * @author Carl, 2024",
+        " */",
+        "",
+        "//Generated, do not edit. %d trees, %d nodes, %d leaves, %d bytes of flash." % (
+            len(roots), len(nodes), len(leaves), flash),
+        "//Worst case %d nodes per frame, about %d cycles." % (worst_case_nodes, cycles),
+        "",
+        '#include "tree_ensemble.h"',
+        "",
+        "//{threshold, right child or leaf, feature, reserved}",
+        "const tree_node_t tree_nodes[] = {",
+    ]
+    for threshold, right, feature in nodes:
+        name = "TREE_LEAF" if feature == TREE_LEAF else "TREE_FEATURE_%s" % FEATURE_NAMES[feature].upper()
+        name = name.replace("BAND_ENERGY_", "BAND_ENERGY + ")
+        lines.append("    {%s, %d, %s, 0}," % (c_float(threshold), right, name))
+    lines += [
+        "};",
+        "",
+        "const uint16_t tree_roots[] = {%s};" % ", ".join(str(root) for root in roots),
+        "",
+        "const float tree_leaf_scores[] = {",
+    ]
+    for scores in leaves:
+        lines.append("    %s," % ", ".join(c_float(s) for s in scores))
+    lines += [
+        "};",
+        "",
+        "const int tree_count = %d;" % len(roots),
+        "const int tree_leaf_kind = %s;" % LEAF_KINDS[kind],
+        "const int tree_worst_case_nodes = %d;" % worst_case_nodes,
+        "",
+    ]
+
+    with open(path, "w") as f:
+        f.write("\n".join(lines))
+    print("%s: %d trees, %d nodes, %d leaves (%s), %d bytes of flash" % (
+        path, len(roots), len(nodes), len(leaves), kind, flash))
+    print("Depth per tree: %s" % ", ".join(str(depth) for depth in depths))
+    print("Worst case per frame: %d nodes, about %d cycles" % (worst_case_nodes, cycles))
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    if sys.argv[1] == "--band-rule":
+        model = band_rule_model()
+        source = "--band-rule"
+    else:
+        with open(sys.argv[1]) as f:
+            model = json.load(f)
+        source = sys.argv[1]
+    write_model(model, sys.argv[2], source)
+
+
+if __name__ == "__main__":
+    main()